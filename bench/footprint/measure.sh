@@ -0,0 +1,59 @@
+#!/bin/sh
+# Compares compile time, stripped binary size and process startup time of a
+# small tool built against the header of a baseline revision and the current
+# header. Older headers rely on <limits> being included transitively, so the
+# baseline is built with BASELINEFLAGS (-include limits by default). A build
+# that fails is reported and the remaining rows are still measured.
+#
+# usage: bench/footprint/measure.sh <baseline-revision> [runs]
+
+if [ -z "$1" ]; then
+    echo "usage: $0 <baseline-revision> [runs]" >&2
+    exit 1
+fi
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+CXX=${CXX:-c++}
+CXXFLAGS=${CXXFLAGS:--std=c++11 -O2}
+BASELINEFLAGS=${BASELINEFLAGS:--include limits}
+RUNS=${2:-1000}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+mkdir -p "$WORK/include"
+git -C "$ROOT" show "$1:include/cppcommandline.h" > "$WORK/include/cppcommandline.h" || exit 1
+
+now()
+{
+    date +%s%N
+}
+
+measure()
+{
+    name=$1
+    shift
+    start=$(now)
+
+    if ! $CXX $CXXFLAGS "$@" "$ROOT/bench/footprint/tool.cpp" -o "$WORK/$name"; then
+        printf "%-16s %10s\n" "$name" "failed"
+        return
+    fi
+
+    compile=$(( ($(now) - start) / 1000000 ))
+    strip "$WORK/$name"
+    size=$(wc -c < "$WORK/$name")
+    start=$(now)
+    i=0
+
+    while [ $i -lt "$RUNS" ]; do
+        "$WORK/$name" file --count 3 > /dev/null
+        i=$((i + 1))
+    done
+
+    startup=$(( ($(now) - start) / RUNS / 1000 ))
+    printf "%-16s %10s ms %12s bytes %10s us/run\n" "$name" "$compile" "$size" "$startup"
+}
+
+printf "%-16s %13s %18s %16s\n" "header" "compile" "stripped size" "startup"
+measure baseline $BASELINEFLAGS -I"$WORK/include"
+measure current -I"$ROOT/include"
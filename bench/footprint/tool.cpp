@@ -0,0 +1,19 @@
+#include <cppcommandline.h>
+
+int main(int argc, char **argv)
+{
+    cppcommandline::Parser commandLine;
+
+    std::string filename;
+    int count = 0;
+    double ratio = 0;
+    bool verbose = false;
+
+    commandLine.option().withDescription("Input file").required().bindTo(filename);
+    commandLine.option("count").asShortName("c").withDefaultValue(10).withDescription("Number of items").bindTo(count);
+    commandLine.option("ratio").withDefaultValue(0.5).withDescription("Sampling ratio").bindTo(ratio);
+    commandLine.option("verbose").asShortName("v").withDefaultValue(false).withDescription("Verbose output").bindTo(verbose);
+    commandLine.parse(argc, argv);
+
+    return count == 0 ? 1 : 0;
+}
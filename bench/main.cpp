@@ -0,0 +1,270 @@
+#include <cppcommandline.h>
+#include <cppcommandlineblob.h>
+#include <cppcommandlinehelp.h>
+
+#ifndef _WIN32
+#include <cppcommandlineserver.h>
+#endif
+
+#ifdef __linux__
+#include <sys/wait.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+
+template<typename Function>
+void benchmark(const char *name, int iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < iterations; i++)
+        function();
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-40s %12.1f ns\n", name, elapsed.count() / iterations);
+}
+
+void longNames(bool frozen)
+{
+    cppcommandline::Parser parser;
+    std::vector<int> values(1000, 0);
+
+    for(std::size_t i = 0; i < values.size(); i++)
+        parser.option("option" + std::to_string(i)).bindTo(values[i]);
+
+    if(frozen)
+        parser.freeze();
+
+    std::vector<const char*> args{"./app", "--option999", "1", "--option500", "2", "--option250", "3", "--option1", "4"};
+    benchmark(frozen ? "1000 long names (frozen)" : "1000 long names (linear)", 10000, [&]() { parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data())); });
+}
+
+void suggestions()
+{
+    cppcommandline::Parser parser;
+
+    for(int i = 0; i < 10000; i++)
+        parser.option("featureflag" + std::to_string(i));
+
+    parser.disableHelp();
+    parser.setOutput([](const std::string &) {});
+    parser.freeze();
+    std::string message;
+
+    for(const char *argument : {"--featurflag1234", "--faetureflgg77"})
+    {
+        std::vector<const char*> args{"./app", argument};
+
+        benchmark((std::string("failed parse, suggestion of 10000 names for ") + argument).c_str(), 1000, [&]() {
+            try
+            {
+                parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+            }
+            catch(std::logic_error &e)
+            {
+                message = e.what();
+            }
+        });
+    }
+}
+
+void numberLists()
+{
+    std::string list;
+
+    for(int i = 0; i < 200000; i++)
+        list += (i ? "," : "") + std::to_string(i * 0.37);
+
+    std::vector<double> values;
+
+    benchmark("200000 doubles, strtod per element", 10, [&]() {
+        values.clear();
+
+        for(const char *at = list.c_str(); *at; at += *at == ',' ? 1 : 0)
+        {
+            char *end = nullptr;
+            values.push_back(std::strtod(at, &end));
+            at = end;
+        }
+    });
+
+    benchmark("200000 doubles, NumberList", 10, [&]() { cppcommandline::NumberList().parse(list.data(), list.size(), values); });
+    benchmark("200000 doubles, NumberList 4 threads", 10, [&]() { cppcommandline::NumberList(',', 4).parse(list.data(), list.size(), values); });
+}
+
+void helpSearch()
+{
+    cppcommandline::Parser parser;
+
+    for(int i = 0; i < 10000; i++)
+        parser.option("generated" + std::to_string(i)).withDescription("Generated option number " + std::to_string(i)).inGroup("Group" + std::to_string(i % 100));
+
+    parser.setOutput([](const std::string &) {});
+    cppcommandline::HelpIndex::enable(parser);
+    parser.freeze();
+    std::vector<const char*> all{"./app", "--help"};
+    std::vector<const char*> term{"./app", "--help=generated1234"};
+    std::vector<const char*> group{"./app", "--help=Group42"};
+    benchmark("help, all of 10000 options", 10, [&]() { parser.parse(static_cast<int>(all.size()), const_cast<char**>(all.data())); });
+    benchmark("help, term among 10000 options", 1000, [&]() { parser.parse(static_cast<int>(term.size()), const_cast<char**>(term.data())); });
+    benchmark("help, group among 10000 options", 1000, [&]() { parser.parse(static_cast<int>(group.size()), const_cast<char**>(group.data())); });
+}
+
+void blobs()
+{
+    std::string hex;
+    std::string base64;
+
+    for(int i = 0; i < 32768; i++)
+        hex += "a7";
+
+    for(int i = 0; i < 16384; i++)
+        base64 += "p6en";
+
+    std::vector<unsigned char> buffer(65536);
+    cppcommandline::Blob hexBlob(buffer.data(), buffer.size(), cppcommandline::Blob::Encoding::Hex);
+    cppcommandline::Blob base64Blob(buffer.data(), buffer.size());
+    std::string copy;
+    cppcommandline::StringView view;
+    cppcommandline::Parser parser;
+    parser.option("hex").bindTo(hexBlob);
+    parser.option("base64").bindTo(base64Blob);
+    parser.option("copy").bindTo(copy);
+    parser.option("view").bindTo(view);
+    parser.freeze();
+    std::vector<const char*> hexArgs{"./app", "--hex", hex.c_str()};
+    std::vector<const char*> base64Args{"./app", "--base64", base64.c_str()};
+    std::vector<const char*> copyArgs{"./app", "--copy", hex.c_str()};
+    std::vector<const char*> viewArgs{"./app", "--view", hex.c_str()};
+    benchmark("32 KB hex blob", 1000, [&]() { parser.parse(static_cast<int>(hexArgs.size()), const_cast<char**>(hexArgs.data())); });
+    benchmark("48 KB base64 blob", 1000, [&]() { parser.parse(static_cast<int>(base64Args.size()), const_cast<char**>(base64Args.data())); });
+    benchmark("64 KB string copy", 1000, [&]() { parser.parse(static_cast<int>(copyArgs.size()), const_cast<char**>(copyArgs.data())); });
+    benchmark("64 KB string view", 1000, [&]() { parser.parse(static_cast<int>(viewArgs.size()), const_cast<char**>(viewArgs.data())); });
+}
+
+#ifndef _WIN32
+void declareTool(cppcommandline::Parser &parser)
+{
+    for(int i = 0; i < 500; i++)
+        parser.option("setting" + std::to_string(i)).withDefaultValue(i).withDescription("Generated setting number " + std::to_string(i));
+
+    parser.option().withDefaultValue(std::string());
+    parser.setOutput([](const std::string &) {});
+}
+
+void warmServer()
+{
+    std::vector<const char*> args{"./tool", "--setting7", "1", "--setting499", "2", "input.txt"};
+
+    benchmark("cold, 500 option schema and parse", 1000, [&]() {
+        cppcommandline::Parser parser;
+        declareTool(parser);
+        parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    });
+
+    const std::string path = "cppcommandlinebench.socket";
+    cppcommandline::Parser parser;
+    declareTool(parser);
+    cppcommandline::ParseServer server(parser, path);
+    std::thread thread([&]() { server.serve(); });
+    cppcommandline::ParseClient client(path);
+    benchmark("warm, 500 option schema over socket", 1000, [&]() { client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data())); });
+    server.stop();
+    thread.join();
+}
+#endif
+
+#ifdef __linux__
+std::size_t privateDirtyKb()
+{
+    std::FILE *file = std::fopen("/proc/self/smaps_rollup", "r");
+    char line[256];
+    std::size_t size = 0;
+
+    while(file && std::fgets(line, sizeof(line), file))
+    {
+        if(std::sscanf(line, "Private_Dirty: %zu kB", &size) == 1)
+            break;
+    }
+
+    if(file)
+        std::fclose(file);
+
+    return size;
+}
+
+void forkedWorkers(bool frozen)
+{
+    cppcommandline::Parser parser;
+    std::vector<int> values(20000, 0);
+
+    for(std::size_t i = 0; i < values.size(); i++)
+        parser.option("option" + std::to_string(i)).withDescription("Generated option number " + std::to_string(i)).bindTo(values[i]);
+
+    if(frozen)
+    {
+        parser.freeze();
+        parser.protectSchema();
+    }
+
+    std::vector<const char*> args{"./worker", "--option19999", "1", "--option5000", "2"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    const int workers = 4;
+    std::size_t growth = 0;
+
+    for(int i = 0; i < workers; i++)
+    {
+        int channel[2];
+
+        if(::pipe(channel) != 0)
+            return;
+
+        const pid_t pid = ::fork();
+
+        if(pid == 0)
+        {
+            const std::size_t before = privateDirtyKb();
+            parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+            const std::size_t dirtied = privateDirtyKb() - before;
+            ssize_t written = ::write(channel[1], &dirtied, sizeof(dirtied));
+            ::_exit(written == sizeof(dirtied) ? 0 : 1);
+        }
+
+        std::size_t dirtied = 0;
+
+        if(::read(channel[0], &dirtied, sizeof(dirtied)) == sizeof(dirtied))
+            growth += dirtied;
+
+        ::waitpid(pid, nullptr, 0);
+        ::close(channel[0]);
+        ::close(channel[1]);
+    }
+
+    std::printf("%-40s %12.1f kB\n", frozen ? "worker dirty pages, 20000 (frozen)" : "worker dirty pages, 20000 (linear)", static_cast<double>(growth) / workers);
+}
+#endif
+
+}
+
+int main()
+{
+    longNames(false);
+    longNames(true);
+    suggestions();
+    numberLists();
+    helpSearch();
+    blobs();
+#ifndef _WIN32
+    warmServer();
+#endif
+#ifdef __linux__
+    forkedWorkers(false);
+    forkedWorkers(true);
+#endif
+    return 0;
+}
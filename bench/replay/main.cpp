@@ -0,0 +1,163 @@
+#include <cppcommandline.h>
+#include <cppcommandlinetrace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+
+namespace
+{
+
+struct Schema
+{
+    std::deque<std::string> strings;
+    std::deque<int> integers;
+    std::deque<long long> longLongs;
+    std::deque<double> doubles;
+    std::deque<bool> bools;
+};
+
+void loadSchema(const std::string &fileName, cppcommandline::Parser &parser, Schema &schema)
+{
+    std::FILE *file = std::fopen(fileName.c_str(), "r");
+
+    if(!file)
+        throw std::runtime_error("Cannot open the schema file '" + fileName + "'.");
+
+    char line[512];
+
+    while(std::fgets(line, sizeof(line), file))
+    {
+        char name[256] = {};
+        char type[32] = {};
+        char shortName[32] = {};
+        const int fields = std::sscanf(line, "%255s %31s %31s", name, type, shortName);
+
+        if(fields < 2 || name[0] == '#')
+            continue;
+
+        cppcommandline::Option &option = std::string(name) == "-" ? parser.option() : parser.option(name);
+
+        if(fields == 3)
+            option.asShortName(shortName);
+
+        const std::string typeName = type;
+
+        if(typeName == "string")
+        {
+            schema.strings.emplace_back();
+            option.bindTo(schema.strings.back());
+        }
+        else if(typeName == "int")
+        {
+            schema.integers.emplace_back();
+            option.bindTo(schema.integers.back());
+        }
+        else if(typeName == "longlong")
+        {
+            schema.longLongs.emplace_back();
+            option.bindTo(schema.longLongs.back());
+        }
+        else if(typeName == "double")
+        {
+            schema.doubles.emplace_back();
+            option.bindTo(schema.doubles.back());
+        }
+        else if(typeName == "bool")
+        {
+            schema.bools.emplace_back();
+            option.bindTo(schema.bools.back());
+        }
+        else
+        {
+            std::fclose(file);
+            throw std::runtime_error("Unknown type '" + typeName + "' of option '" + name + "'.");
+        }
+    }
+
+    std::fclose(file);
+}
+
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    return sorted[static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1))];
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    cppcommandline::Parser commandLine;
+    std::string traceFile;
+    std::string schemaFile;
+    int iterations = 1;
+    bool frozen = false;
+    commandLine.option("trace").asShortName("t").required().withDescription("Trace file written by TraceRecorder").bindTo(traceFile);
+    commandLine.option("schema").asShortName("s").required().withDescription("Option schema, one 'name type [short]' per line").bindTo(schemaFile);
+    commandLine.option("iterations").asShortName("i").withDefaultValue(1).withRange(1, 1000000).withDescription("Number of passes over the trace").bindTo(iterations);
+    commandLine.option("frozen").asShortName("f").withDefaultValue(false).withDescription("Freeze the replayed parser").bindTo(frozen);
+    commandLine.parse(argc, argv);
+
+    if(commandLine.helpDisplayed())
+        return 0;
+
+    cppcommandline::Parser parser;
+    Schema schema;
+    loadSchema(schemaFile, parser, schema);
+    parser.disableHelp();
+    parser.setOutput([](const std::string &) {});
+
+    if(frozen)
+        parser.freeze();
+
+    std::deque<cppcommandline::TraceRecord> records;
+    cppcommandline::TraceReader reader(traceFile);
+
+    for(cppcommandline::TraceRecord record; reader.next(record);)
+    {
+        if(record.kind() == cppcommandline::TraceRecord::Kind::Arguments)
+            records.push_back(record);
+    }
+
+    if(records.empty())
+    {
+        std::fprintf(stderr, "The trace '%s' contains no argument records.\n", traceFile.c_str());
+        return 1;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(records.size() * static_cast<std::size_t>(iterations));
+    std::size_t errors = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < iterations; i++)
+    {
+        for(cppcommandline::TraceRecord &record : records)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+
+            try
+            {
+                parser.parse(record.count(), record.arguments());
+            }
+            catch(std::exception &)
+            {
+                errors++;
+            }
+
+            latencies.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count());
+        }
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("parses      %12zu\n", latencies.size());
+    std::printf("errors      %12zu\n", errors);
+    std::printf("p50         %12.1f ns\n", percentile(latencies, 0.5));
+    std::printf("p90         %12.1f ns\n", percentile(latencies, 0.9));
+    std::printf("p99         %12.1f ns\n", percentile(latencies, 0.99));
+    std::printf("max         %12.1f ns\n", latencies.back());
+    std::printf("throughput  %12.0f parses/s\n", static_cast<double>(latencies.size()) / elapsed.count());
+    return 0;
+}
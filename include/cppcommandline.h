@@ -1,606 +1,3728 @@
 #pragma once
 
 #include <vector>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <type_traits>
 #include <string>
 #include <stdexcept>
-#include <regex>
 #include <memory>
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPPCOMMANDLINE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(CPPCOMMANDLINE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPPCOMMANDLINE_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace cppcommandline
 {
 
-class Option
+class NumberList
 {
 public:
-    Option() :
-        d(std::unique_ptr<OptionPrivate>(new OptionPrivate))
+    explicit NumberList(char delimiter = ',', unsigned threads = 1) :
+        mDelimiter(delimiter),
+        mThreads(threads == 0 ? 1 : threads)
     {
 
     }
 
-    explicit Option(std::string longName) :
-        d(std::unique_ptr<OptionPrivate>(new OptionPrivate))
+    char delimiter() const
     {
-        if(!isLongName(longName))
-            throw std::logic_error("The name '" + longName + "' is not a valid option name.");
-        else
-            d->longName = longName;
+        return mDelimiter;
     }
 
-    Option(Option &&option) :
-        d(option.d.release())
+    std::size_t count(const char *list, std::size_t size) const
     {
-
+        return size == 0 ? 0 : countDelimiters(list, size) + 1;
     }
 
-    Option(const Option &option) = delete;
-
-    Option &operator=(Option &&option)
+    template<typename T>
+    bool parse(const char *list, std::size_t size, T *values) const
     {
-        d.reset(option.d.release()); return *this;
+        if(mThreads > 1 && size >= ParallelThreshold)
+            return parseParallel(list, size, values);
+        else
+            return size == 0 || parseRange(list, list + size, values);
     }
 
-    bool operator==(const Option &other) const
+    template<typename T>
+    bool parse(const char *list, std::size_t size, std::vector<T> &values) const
     {
-        return d->defaultStringValue == other.d->defaultStringValue
-            && d->description == other.d->description
-            && d->longName == other.d->longName
-            && d->required == other.d->required
-            && d->shortName == other.d->shortName
-            && d->type == other.d->type;
-        //TODO: Compare the union values.
+        values.resize(count(list, size));
+        return parse(list, size, values.data());
     }
 
-    bool isPositional() const
+private:
+    enum : std::size_t
     {
-        return d->longName.empty();
-    }
+        ParallelThreshold = 1 << 18,
+        MaxDigits = 19,
+        MaxExactDigits = 15
+    };
 
-    std::string longName() const
+    std::size_t countDelimiters(const char *list, std::size_t size) const
     {
-        return d->longName;
-    }
+        std::size_t count = 0;
+        std::size_t offset = 0;
 
-    std::string shortName() const
-    {
-        return d->shortName;
-    }
+#ifdef CPPCOMMANDLINE_AVX2
+        if(hasAvx2())
+            offset = countAvx2(list, size, count);
+#endif
+#ifdef CPPCOMMANDLINE_SSE2
+        offset += countSse2(list + offset, size - offset, count);
+#endif
 
-    std::string description() const
-    {
-        return d->description;
-    }
+        for(; offset < size; offset++)
+            count += list[offset] == mDelimiter ? 1 : 0;
 
-    bool isRequired() const
-    {
-        return d->required;
+        return count;
     }
 
-    template<typename T>
-    T defaultValue() const
+#ifdef CPPCOMMANDLINE_SSE2
+    std::size_t countSse2(const char *list, std::size_t size, std::size_t &count) const
     {
-        T val;
+        const __m128i delimiter = _mm_set1_epi8(mDelimiter);
+        std::size_t offset = 0;
 
-        if(d->type != Type::Undefined)
+        for(; offset + 16 <= size; offset += 16)
         {
-            if(getType<T>() == d->type)
-                val = getDefaultValue<T>();
-            else
-                throw std::logic_error("Type mismatch: requesting '" + getTypeAsString(getType<T>()) + "' but the set type is '" + getTypeAsString(d->type) + "'");
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(list + offset));
+            count += bitCount(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, delimiter))));
         }
 
-        return val;
+        return offset;
     }
+#endif
 
-    std::string defaultValueAsString() const
+#ifdef CPPCOMMANDLINE_AVX2
+    static bool hasAvx2()
+    {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    __attribute__((target("avx2"))) std::size_t countAvx2(const char *list, std::size_t size, std::size_t &count) const
     {
-        std::ostringstream stream;
+        const __m256i delimiter = _mm256_set1_epi8(mDelimiter);
+        std::size_t offset = 0;
 
-        switch(d->type)
+        for(; offset + 32 <= size; offset += 32)
         {
-        case Type::Bool: d->defaultValue.b ? stream << "true" : stream << "false"; break;
-        case Type::Double: stream << d->defaultValue.d; break;
-        case Type::Integer: stream << d->defaultValue.i; break;
-        case Type::LongLong: stream << d->defaultValue.l; break;
-        case Type::String: stream << d->defaultStringValue; break;
-        case Type::Undefined: break;
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(list + offset));
+            count += bitCount(static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, delimiter))));
         }
 
-        return stream.str();
+        return offset;
     }
+#endif
 
-    bool hasDefaultValue() const
+    static std::size_t bitCount(std::uint32_t bits)
     {
-        return d->defaulted;
+#ifdef __GNUC__
+        return static_cast<std::size_t>(__builtin_popcount(bits));
+#else
+        std::size_t count = 0;
+
+        for(; bits; bits &= bits - 1)
+            ++count;
+
+        return count;
+#endif
     }
 
     template<typename T>
-    T *boundValue() const
+    bool parseParallel(const char *list, std::size_t size, T *values) const
     {
-        T *val = nullptr;
+        const char *end = list + size;
+        std::vector<const char*> bounds(mThreads + 1, end);
+        std::vector<std::size_t> offsets(mThreads + 1, 0);
+        std::vector<char> results(mThreads, 1);
+        bounds[0] = list;
 
-        if(d->type != Type::Undefined)
+        for(unsigned i = 1; i < mThreads; i++)
         {
-            if(d->type != Type::Undefined)
-            {
-                if(getType<T>() == d->type)
-                    val = getBoundValue<T>();
-                else
-                    throw std::logic_error("Type mismatch: requesting '" + getTypeAsString(getType<T>()) + "' but the set type is '" + getTypeAsString(d->type) + "'");
-            }
+            const char *at = std::max(list + size / mThreads * i, bounds[i - 1]);
+            const void *delimiter = std::memchr(at, mDelimiter, static_cast<std::size_t>(end - at));
+            bounds[i] = delimiter ? static_cast<const char*>(delimiter) + 1 : end;
         }
 
-        return val;
-    }
+        runParallel([&](unsigned i) { offsets[i + 1] = countDelimiters(bounds[i], static_cast<std::size_t>(bounds[i + 1] - bounds[i])); });
 
-    Option &asShortName(std::string shortName)
-    {
-        if(d->longName.empty())
-            throw std::logic_error("Short name cannot be defined for positional arguments.");
-        else if(!isShortName(shortName))
-            throw std::logic_error("The name '" + shortName + "' is not a valid short option name.");
-        else if(d->shortName.empty())
-            d->shortName = shortName;
-        else
-            throw std::logic_error("The option '" + shortName + "' already has a short name + '" + d->shortName + "'.");
-        return *this;
-    }
+        for(unsigned i = 0; i < mThreads; i++)
+            offsets[i + 1] += offsets[i];
 
-    Option &required()
-    {
-        if(!d->defaulted)
-            d->required = true;
-        else
-            throw std::logic_error("The option " + getName() + " has default value and cannot be set as required.");
-        return *this;
+        runParallel([&](unsigned i)
+        {
+            if(bounds[i] != bounds[i + 1])
+                results[i] = parseRange(bounds[i], bounds[i + 1] == end ? end : bounds[i + 1] - 1, values + offsets[i]);
+        });
+
+        return std::find(results.cbegin(), results.cend(), 0) == results.cend();
     }
 
-    Option &withDescription(std::string description)
+    template<typename Function>
+    void runParallel(const Function &function) const
     {
-        if(d->description.empty())
-            d->description = description;
-        else
-            throw std::logic_error("The option " + getName() + " already has a description.");
-        return *this;
+        std::vector<std::thread> threads;
+
+        for(unsigned i = 1; i < mThreads; i++)
+            threads.emplace_back(function, i);
+
+        function(0);
+
+        for(std::thread &thread : threads)
+            thread.join();
     }
 
     template<typename T>
-    Option &withDefaultValue(T defaultValue)
+    bool parseRange(const char *at, const char *end, T *values) const
     {
-        if(d->required)
-            throw std::logic_error("The option " + getName() + " is set as required and cannot have default value assigned.");
-        else
+        for(;; ++at)
         {
-            setDefault(defaultValue);
-            d->type = getType<T>();
-            d->defaulted = true;
+            if(!parseNumber(at, end, *values++))
+                return false;
+            else if(at == end)
+                return true;
+            else if(*at != mDelimiter)
+                return false;
         }
-        return *this;
     }
 
-    template<typename T>
-    void bindTo(T &value)
+    static bool parseNumber(const char *&at, const char *end, int &value)
     {
-        if(d->type == Type::Undefined)
-            d->type = getType<T>();
-        else if(!defaultTypeCompatibleWithBoundType(d->type, getType<T>()))
-            throw std::logic_error("The option " + getName() + " has default value set with incompatible type (" + getTypeAsString(d->type) + ") to the one it is being bound to (" + getTypeAsString(getType<T>()) + ")" );
-        setValueBinding(&value);
+        long long number = 0;
+
+        if(!parseNumber(at, end, number) || number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max())
+            return false;
+
+        value = static_cast<int>(number);
+        return true;
     }
 
-    std::vector<std::string>::const_iterator match(std::vector<std::string>::const_iterator argument, std::vector<std::string>::const_iterator end)
+    static bool parseNumber(const char *&at, const char *end, long long &value)
     {
-        KeyValue keyValue = getKeyValue(*argument);
-
-        if(keyValue.key.empty())
-        {
-            if(isPositional())
-            {
-                if(setValue(*argument))
-                    ++argument;
-            }
-        }
-        else if((isLongNameArgument(*argument) && keyValue.key == longName()) || (isShortNameArgument(*argument) && keyValue.key == shortName()))
-        {
-            if(d->type == Type::Bool)
-            {
-                if(setValue(*argument))
-                    ++argument;
-            }
-            else if(keyValue.value.empty())
-            {
-                std::vector<std::string>::const_iterator it = argument+1;
+        const bool negative = at != end && *at == '-';
+        std::uint64_t magnitude = 0;
+        at += negative ? 1 : 0;
 
-                if(it == end)
-                    throw(std::logic_error("Missing value for option '" + (longName().empty() ? "[positional]" : longName()) + "'"));
-                else if(setValue(*it))
-                    argument += 2;
-            }
-            else if(setValue(keyValue.value))
-                ++argument;
-        }
+        if(parseDigits(at, end, magnitude) == 0 || (at != end && isDigit(*at)))
+            return false;
+        else if(magnitude > static_cast<std::uint64_t>(std::numeric_limits<long long>::max()) + (negative ? 1 : 0))
+            return false;
 
-        return argument;
+        value = negative ? static_cast<long long>(0 - magnitude) : static_cast<long long>(magnitude);
+        return true;
     }
 
-private:
-    enum class Type
+    static bool parseNumber(const char *&at, const char *end, double &value)
     {
-        Undefined,
-        String,
-        Integer,
-        LongLong,
-        Double,
-        Bool
-    };
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+        const char *begin = at;
+        const bool negative = at != end && *at == '-';
+        std::uint64_t mantissa = 0;
+        at += negative ? 1 : 0;
+        const std::size_t digits = parseDigits(at, end, mantissa);
+        std::size_t skipped = skipDigits(at, end);
+        std::size_t fraction = 0;
+
+        if(digits == 0)
+            return false;
+
+        if(at != end && *at == '.')
+        {
+            if(++at == end || !isDigit(*at))
+                return false;
 
-    union DefaultValue
-    {
-        int i;
-        long long l;
-        double d;
-        bool b = false;
-    };
+            fraction = skipped ? 0 : parseDigits(at, end, mantissa, MaxDigits - digits);
+            skipped += skipDigits(at, end);
+        }
 
-    union ValueBinding
-    {
-        std::string *s;
-        int *i;
-        long long *l;
-        double *d;
-        bool *b = nullptr;
-    };
+        if(skipped || digits + fraction > MaxExactDigits)
+            return parseDouble(begin, at, value);
 
-    struct KeyValue
-    {
-        std::string key;
-        std::string value;
-    };
+        value = static_cast<double>(mantissa) / powers[fraction];
+        value = negative ? -value : value;
+        return true;
+    }
 
-    struct OptionPrivate
+    static bool parseDouble(const char *begin, const char *end, double &value)
     {
-        std::string longName;
-        std::string shortName;
-        std::string defaultStringValue;
-        std::string description;
-        Option::DefaultValue defaultValue;
-        Option::ValueBinding valueBinding;
-        Option::Type type = Type::Undefined;
-        bool required = false;
-        bool defaulted = false;
-    };
-
-    template<typename T> T *getBoundValue() const;
-    template<typename T> T getDefaultValue() const;
-    template<typename T> void setDefault(T);
-    template<typename T> void setValueBinding(T*);
-    template<typename T> Type getType() const;
+        const std::string number(begin, end);
+        value = std::strtod(number.c_str(), nullptr);
+        return true;
+    }
 
-    bool setValue(std::string value)
+    static std::size_t parseDigits(const char *&at, const char *end, std::uint64_t &value, std::size_t limit = MaxDigits)
     {
-        bool result = true;
+        std::size_t digits = 0;
 
-        class ValueParseError : public std::logic_error
+#ifdef CPPCOMMANDLINE_SSE2
+        for(std::uint64_t block; digits + 8 <= limit && end - at >= 8; at += 8, digits += 8)
         {
-        public:
-            ValueParseError() :
-                std::logic_error("...")
-            {
+            std::memcpy(&block, at, 8);
 
-            }
-        };
-
-        try
-        {
-            switch(d->type)
-            {
-            case Type::Bool:
-                *d->valueBinding.b = true;
-                break;
-            case Type::Double:
-                if(isDouble(value))
-                    *d->valueBinding.d = std::stod(value);
-                else
-                    throw(ValueParseError());
+            if(!isEightDigits(block))
                 break;
-            case Type::Integer:
-                if(isInteger(value))
-                    *d->valueBinding.i = std::stoi(value);
-                else
-                    throw(ValueParseError());
-                break;
-            case Type::LongLong:
-                if(isLongLong(value))
-                    *d->valueBinding.l = std::stoll(value);
-                else
-                    throw(ValueParseError());
-                break;
-            case Type::String:
-                *d->valueBinding.s = value;
-                break;
-            case Type::Undefined:
-                throw(std::logic_error("Bind value undefined for option '" + (longName().empty() ? "[positional]" : longName()) + "'"));
-                break;
-            }
-        }
-        catch(ValueParseError&)
-        {
-            result = false;
+
+            value = value * 100000000 + eightDigits(block);
         }
+#endif
 
-        return result;
-    }
+        for(; digits < limit && at != end && isDigit(*at); ++at, ++digits)
+            value = value * 10 + static_cast<std::uint64_t>(*at - '0');
 
-    std::string getName() const
-    {
-        return d->longName.empty() ? "[Positional]" : "'" + d->longName + "'";
+        return digits;
     }
 
-    std::string getTypeAsString(Type type) const
+    static std::size_t skipDigits(const char *&at, const char *end)
     {
-        std::string val = "Undefined";
+        const char *begin = at;
 
-        switch(type)
-        {
-        case Type::Bool: val = "bool"; break;
-        case Type::Double: val = "double"; break;
-        case Type::Integer: val = "int"; break;
-        case Type::LongLong: val = "long long"; break;
-        case Type::String: val = "string"; break;
-        case Type::Undefined: break;
-        }
+        while(at != end && isDigit(*at))
+            ++at;
 
-        return val;
+        return static_cast<std::size_t>(at - begin);
     }
 
-    KeyValue getKeyValue(std::string argument) const
+    static bool isEightDigits(std::uint64_t block)
     {
-        KeyValue keyValue;
-        std::cmatch m;
-        if(std::regex_match(argument.c_str(), m, std::regex("^(--|-)([a-zA-Z][a-zA-Z\\d]*)((=(.*))|)")))
-        {
-            keyValue.key = m.size() > 2 ? std::string(m[2]) : "";
-            keyValue.value = m.size() > 4 ? std::string(m[5]) : "";
-        }
-        else
-            keyValue.value = argument;
-        return keyValue;
+        return ((block & 0xF0F0F0F0F0F0F0F0ull) | (((block + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
     }
 
-    bool defaultTypeCompatibleWithBoundType(Type defaultType, Type boundType) const
+    static std::uint64_t eightDigits(std::uint64_t block)
     {
-        return defaultType != Type::Undefined && boundType != Type::Undefined && (defaultType == boundType || (defaultType == Type::Integer && boundType == Type::LongLong));
+        block -= 0x3030303030303030ull;
+        block = (block * 10) + (block >> 8);
+        return (((block & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) + (((block >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+    }
+
+    static bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
     }
 
-    bool isLongNameArgument(std::string argument) const
+    char mDelimiter;
+    unsigned mThreads;
+};
+
+class StringView
+{
+public:
+    StringView() = default;
+
+    StringView(const char *data, std::size_t size) :
+        mData(data),
+        mSize(size)
     {
-        return std::regex_match(argument, std::regex("^--[a-zA-Z][a-zA-Z\\d]*.*$"));
+
     }
 
-    bool isShortNameArgument(std::string argument) const
+    const char *data() const
     {
-        return std::regex_match(argument, std::regex("^-[a-zA-Z].*$"));
+        return mData;
     }
 
-    bool isInteger(std::string argument) const
+    std::size_t size() const
     {
-        return isNumber(argument) && (std::stoi(argument) <= std::numeric_limits<int>::min() || std::stoll(argument) <= std::numeric_limits<int>::max());
+        return mSize;
     }
 
-    bool isLongLong(std::string argument) const
+    bool empty() const
     {
-        return isNumber(argument);
+        return mSize == 0;
     }
 
-    bool isDouble(std::string argument) const
+    std::string str() const
     {
-        return std::regex_match(argument, std::regex("^(-|)\\d+\\.\\d+$"));
+        return std::string(mData, mSize);
     }
 
-    bool isNumber(std::string argument) const
+private:
+    const char *mData = "";
+    std::size_t mSize = 0;
+};
+
+class StringLiteral
+{
+public:
+    const char *data() const
     {
-        return std::regex_match(argument, std::regex("^(-|)\\d+$"));
+        return mData;
     }
 
-    bool isLongName(std::string longName) const
+    std::size_t size() const
     {
-        return std::regex_match(longName, std::regex("^[a-zA-Z\\d]+$"));
+        return mSize;
     }
 
-    bool isShortName(std::string shortName) const
+private:
+    StringLiteral(const char *data, std::size_t size) :
+        mData(data),
+        mSize(size)
     {
-        return std::regex_match(shortName, std::regex("^[a-zA-Z\\d]$"));
+
     }
 
-    std::unique_ptr<OptionPrivate> d;
+    const char *mData;
+    std::size_t mSize;
+
+    template<std::size_t N> friend StringLiteral literal(const char (&text)[N]);
 };
 
-template<> std::string *Option::getBoundValue() const { return d->valueBinding.s; }
-template<> int *Option::getBoundValue() const { return d->valueBinding.i; }
-template<> long long *Option::getBoundValue() const { return d->valueBinding.l; }
-template<> double *Option::getBoundValue() const { return d->valueBinding.d; }
-template<> bool *Option::getBoundValue() const { return d->valueBinding.b; }
-template<> std::string Option::getDefaultValue() const { return d->defaultStringValue; }
-template<> int Option::getDefaultValue() const { return d->defaultValue.i; }
-template<> long long Option::getDefaultValue() const { return d->defaultValue.l; }
-template<> double Option::getDefaultValue() const { return d->defaultValue.d; }
-template<> bool Option::getDefaultValue() const { return d->defaultValue.b; }
-template<> void Option::setDefault(std::string defaultValue) { d->defaultStringValue = defaultValue; }
-template<> void Option::setDefault(int defaultValue) { d->defaultValue.i = defaultValue; }
-template<> void Option::setDefault(long long defaultValue) { d->defaultValue.l = defaultValue; }
-template<> void Option::setDefault(double defaultValue) { d->defaultValue.d = defaultValue; }
-template<> void Option::setDefault(bool defaultValue) { d->defaultValue.b = defaultValue; }
-template<> void Option::setValueBinding(std::string *binding) { d->valueBinding.s = binding; if(d->defaulted) *binding = d->defaultStringValue; }
-template<> void Option::setValueBinding(int *binding) { d->valueBinding.i = binding; if(d->defaulted) *binding = d->defaultValue.i; }
-template<> void Option::setValueBinding(long long *binding) { d->valueBinding.l = binding; if(d->defaulted) *binding = d->defaultValue.l; }
-template<> void Option::setValueBinding(double *binding) { d->valueBinding.d = binding; if(d->defaulted) *binding = d->defaultValue.d; }
-template<> void Option::setValueBinding(bool *binding) { d->valueBinding.b = binding; if(d->defaulted) *binding = d->defaultValue.b; }
-template<> Option::Type Option::getType<std::string>() const { return Type::String; }
-template<> Option::Type Option::getType<int>() const { return Type::Integer; }
-template<> Option::Type Option::getType<long long>() const { return Type::LongLong; }
-template<> Option::Type Option::getType<bool>() const { return Type::Bool; }
-template<> Option::Type Option::getType<double>() const { return Type::Double; }
+template<std::size_t N>
+StringLiteral literal(const char (&text)[N])
+{
+    return StringLiteral(text, N - 1);
+}
 
-class Parser
+class InternedString
 {
 public:
-    bool helpEnabled() const
+    InternedString() = default;
+
+    std::uint32_t id() const
     {
-        return mHelp;
+        return mId;
     }
 
-    void disableHelp()
+    const char *data() const
     {
-        mHelp = false;
+        return mData;
     }
 
-    std::string command() const
+    std::size_t size() const
     {
-        return mCommand;
+        return mSize;
     }
 
-    std::string applicationName() const
+    bool empty() const
     {
-        return mAppName;
+        return mSize == 0;
     }
 
-    bool helpDisplayed() const
+    char operator[](std::size_t index) const
     {
-        return mHelpDisplayed;
+        return mData[index];
     }
 
-    Option &option()
+    std::string str() const
     {
-        mOptions.emplace_back(Option());
-        return mOptions.back();
+        return std::string(mData, mSize);
     }
 
-    Option &option(std::string longName)
+    int compare(std::size_t position, std::size_t count, const char *text, std::size_t size) const
     {
-        mOptions.emplace_back(Option(longName));
-        return mOptions.back();
+        const std::size_t length = std::min(count, mSize - position);
+        const int result = std::memcmp(mData + position, text, std::min(length, size));
+        return result != 0 ? result : (length < size ? -1 : (length > size ? 1 : 0));
     }
 
-    void parse(int argc, char **argv)
+    bool operator==(const InternedString &other) const
     {
-        try
+        return mId != 0 && other.mId != 0 ? mId == other.mId : compare(0, mSize, other.mData, other.mSize) == 0;
+    }
+
+    bool operator!=(const InternedString &other) const
+    {
+        return !(*this == other);
+    }
+
+    bool operator==(const std::string &other) const
+    {
+        return compare(0, mSize, other.data(), other.size()) == 0;
+    }
+
+    bool operator<(const InternedString &other) const
+    {
+        return compare(0, mSize, other.mData, other.mSize) < 0;
+    }
+
+    friend std::string operator+(const std::string &left, const InternedString &right)
+    {
+        return left + right.str();
+    }
+
+    friend std::string operator+(const InternedString &left, const std::string &right)
+    {
+        return left.str() + right;
+    }
+
+private:
+    InternedString(std::uint32_t id, const char *data, std::size_t size) :
+        mData(data),
+        mId(id),
+        mSize(static_cast<std::uint32_t>(size))
+    {
+
+    }
+
+    typedef InternedString (*Interner)(const char *text, std::size_t size, bool copy);
+
+    static std::atomic<Interner> &interner()
+    {
+        static std::atomic<Interner> interner(nullptr);
+        return interner;
+    }
+
+    const char *mData = "";
+    std::uint32_t mId = 0;
+    std::uint32_t mSize = 0;
+
+    friend class Option;
+    friend class StringPool;
+};
+
+class LazyValue
+{
+public:
+    bool isMatched() const
+    {
+        return mMatched;
+    }
+
+protected:
+    LazyValue() = default;
+    LazyValue(const LazyValue &other) = delete;
+    LazyValue &operator=(const LazyValue &other) = delete;
+
+    std::string mToken;
+    std::string mName;
+    bool mMatched = false;
+    mutable bool mConverted = true;
+
+    friend class Option;
+};
+
+template<typename T> class Lazy;
+class Blob;
+
+class CancellationToken
+{
+public:
+    bool isCancelled() const
+    {
+        return mCancelled && mCancelled->load(std::memory_order_acquire);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> mCancelled;
+
+    friend class Option;
+    friend class Parser;
+};
+
+class Option
+{
+public:
+    Option() :
+        d(std::unique_ptr<OptionPrivate>(new OptionPrivate))
+    {
+
+    }
+
+    explicit Option(std::string longName) :
+        d(std::unique_ptr<OptionPrivate>(new OptionPrivate))
+    {
+        if(!isLongName(longName.data(), longName.size()))
+            throw std::logic_error("The name '" + longName + "' is not a valid option name.");
+        else
+            assign(d->longName, d->longNameCopy, longName.data(), longName.size(), true);
+    }
+
+    explicit Option(StringLiteral longName) :
+        d(std::unique_ptr<OptionPrivate>(new OptionPrivate))
+    {
+        if(!isLongName(longName.data(), longName.size()))
+            throw std::logic_error("The name '" + std::string(longName.data(), longName.size()) + "' is not a valid option name.");
+        else
+            assign(d->longName, d->longNameCopy, longName.data(), longName.size(), false);
+    }
+
+    Option(Option &&option) :
+        d(option.d.release())
+    {
+
+    }
+
+    Option(const Option &option) = delete;
+
+    Option &operator=(Option &&option)
+    {
+        d.reset(option.d.release()); return *this;
+    }
+
+    bool operator==(const Option &other) const
+    {
+        return d->defaultStringValue == other.d->defaultStringValue
+            && d->description == other.d->description
+            && d->longName == other.d->longName
+            && d->required == other.d->required
+            && d->shortName == other.d->shortName
+            && d->type == other.d->type;
+        //TODO: Compare the union values.
+    }
+
+    bool isPositional() const
+    {
+        return d->longName.empty();
+    }
+
+    std::string longName() const
+    {
+        return d->longName.str();
+    }
+
+    std::string shortName() const
+    {
+        return d->shortName.str();
+    }
+
+    std::string description() const
+    {
+        return d->description.str();
+    }
+
+    bool isRequired() const
+    {
+        return d->required;
+    }
+
+    template<typename T>
+    T defaultValue() const
+    {
+        T val;
+
+        if(d->type != Type::Undefined)
+        {
+            if(getType<T>() == d->type)
+                val = getDefaultValue<T>();
+            else
+                throw std::logic_error("Type mismatch: requesting '" + getTypeAsString(getType<T>()) + "' but the set type is '" + getTypeAsString(d->type) + "'");
+        }
+
+        return val;
+    }
+
+    std::string defaultValueAsString() const
+    {
+        return d->type == Type::String ? d->defaultStringValue : valueAsString(d->type, d->defaultValue);
+    }
+
+    bool hasDefaultValue() const
+    {
+        return d->defaulted;
+    }
+
+    template<typename T>
+    T *boundValue() const
+    {
+        T *val = nullptr;
+
+        if(d->type != Type::Undefined && !d->lazy)
+        {
+            if(d->type != Type::Undefined)
+            {
+                if(getType<T>() == d->type)
+                    val = getBoundValue<T>();
+                else
+                    throw std::logic_error("Type mismatch: requesting '" + getTypeAsString(getType<T>()) + "' but the set type is '" + getTypeAsString(d->type) + "'");
+            }
+        }
+
+        return val;
+    }
+
+    Option &asShortName(std::string shortName)
+    {
+        checkNotFrozen();
+
+        if(d->longName.empty())
+            throw std::logic_error("Short name cannot be defined for positional arguments.");
+        else if(!isShortName(shortName))
+            throw std::logic_error("The name '" + shortName + "' is not a valid short option name.");
+        else if(d->shortName.empty())
+            assign(d->shortName, d->shortNameCopy, shortName.data(), shortName.size(), true);
+        else
+            throw std::logic_error("The option '" + shortName + "' already has a short name + '" + d->shortName + "'.");
+        return *this;
+    }
+
+    Option &required()
+    {
+        checkNotFrozen();
+
+        if(!d->defaulted)
+            d->required = true;
+        else
+            throw std::logic_error("The option " + getName() + " has default value and cannot be set as required.");
+        return *this;
+    }
+
+    Option &withDescription(std::string description)
+    {
+        if(d->description.empty())
+            assign(d->description, d->descriptionCopy, description.data(), description.size(), true);
+        else
+            throw std::logic_error("The option " + getName() + " already has a description.");
+        return *this;
+    }
+
+    Option &withDescription(StringLiteral description)
+    {
+        if(d->description.empty())
+            assign(d->description, d->descriptionCopy, description.data(), description.size(), false);
+        else
+            throw std::logic_error("The option " + getName() + " already has a description.");
+        return *this;
+    }
+
+    Option &inGroup(std::string group)
+    {
+        checkNotFrozen();
+
+        if(group.empty())
+            throw std::logic_error("The group of option " + getName() + " cannot be empty.");
+        else if(d->group.empty())
+            assign(d->group, d->groupCopy, group.data(), group.size(), true);
+        else
+            throw std::logic_error("The option " + getName() + " is already in group '" + d->group + "'.");
+        return *this;
+    }
+
+    std::string group() const
+    {
+        return d->group.str();
+    }
+
+    template<typename T>
+    Option &withDefaultValue(T defaultValue)
+    {
+        checkNotFrozen();
+
+        if(d->required)
+            throw std::logic_error("The option " + getName() + " is set as required and cannot have default value assigned.");
+        else if((d->ranged || !d->choices.empty()) && d->type != getType<T>())
+            throw std::logic_error("The option " + getName() + " has constraints of type (" + getTypeAsString(d->type) + ") incompatible with the default value type (" + getTypeAsString(getType<T>()) + ")");
+        else
+        {
+            setDefault(defaultValue);
+            d->type = getType<T>();
+            d->defaulted = true;
+            checkDefaultValue();
+        }
+        return *this;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_same<T, int>::value || std::is_same<T, long long>::value || std::is_same<T, double>::value, Option&>::type withRange(T minimum, T maximum)
+    {
+        checkNotFrozen();
+
+        if(d->lazy)
+            throw std::logic_error("The lazily bound option " + getName() + " cannot have a range.");
+        else if(d->type != Type::Undefined && d->type != getType<T>())
+            throw std::logic_error("The option " + getName() + " has type (" + getTypeAsString(d->type) + ") incompatible with the range type (" + getTypeAsString(getType<T>()) + ")");
+        else if(maximum < minimum)
+            throw std::logic_error("The range of option " + getName() + " is empty.");
+
+        d->type = getType<T>();
+        setRange(minimum, maximum);
+        d->ranged = true;
+        checkDefaultValue();
+        return *this;
+    }
+
+    Option &withChoices(std::vector<std::string> choices)
+    {
+        checkNotFrozen();
+
+        if(d->lazy)
+            throw std::logic_error("The lazily bound option " + getName() + " cannot have choices.");
+        else if(d->type != Type::Undefined && d->type != Type::String)
+            throw std::logic_error("The option " + getName() + " has type (" + getTypeAsString(d->type) + ") and cannot have string choices.");
+        else if(choices.empty())
+            throw std::logic_error("The option " + getName() + " needs at least one choice.");
+
+        d->type = Type::String;
+        d->choices = std::move(choices);
+        checkDefaultValue();
+        return *this;
+    }
+
+    Option &excludes(std::string longName)
+    {
+        checkNotFrozen();
+
+        if(d->longName.empty())
+            throw std::logic_error("Positional arguments cannot exclude other options.");
+
+        d->excludes.push_back(std::move(longName));
+        return *this;
+    }
+
+    Option &dependsOn(std::string longName)
+    {
+        checkNotFrozen();
+
+        if(d->longName.empty())
+            throw std::logic_error("Positional arguments cannot depend on other options.");
+
+        d->dependencies.push_back(std::move(longName));
+        return *this;
+    }
+
+    Option &withListDelimiter(char delimiter)
+    {
+        checkNotFrozen();
+
+        if(isDigit(delimiter) || delimiter == '-' || delimiter == '.' || delimiter == '\0')
+            throw std::logic_error("The character '" + std::string(1, delimiter) + "' cannot delimit the values of option " + getName() + ".");
+
+        d->listDelimiter = delimiter;
+        return *this;
+    }
+
+    Option &withListThreads(unsigned threads)
+    {
+        checkNotFrozen();
+        d->listThreads = threads;
+        return *this;
+    }
+
+    Option &onMatch(std::function<void(const CancellationToken &token)> action)
+    {
+        checkNotFrozen();
+        d->action = std::move(action);
+        d->actionRunner = d->action ? &Option::runAction : nullptr;
+        return *this;
+    }
+
+    template<typename T>
+    void bindTo(T &value)
+    {
+        checkNotFrozen();
+        setBoundType(getType<T>());
+        setValueBinding(&value);
+        setConverter(&value);
+    }
+
+    template<typename T>
+    void bindTo(Lazy<T> &value)
+    {
+        checkNotFrozen();
+
+        if(d->ranged || !d->choices.empty())
+            throw std::logic_error("The option " + getName() + " has constraints on its value and cannot be bound lazily.");
+
+        setBoundType(getType<T>());
+        value.mName = getName();
+        value.mMatched = false;
+        value.mConverted = true;
+        value.mValue = d->defaulted ? getDefaultValue<T>() : T();
+        d->valueBinding.z = &value;
+        d->lazy = true;
+    }
+
+    template<typename T, std::size_t N>
+    void bindTo(std::array<T, N> &value)
+    {
+        bindToTuple(value);
+    }
+
+    template<typename First, typename Second>
+    void bindTo(std::pair<First, Second> &value)
+    {
+        bindToTuple(value);
+    }
+
+    template<typename... T>
+    void bindTo(std::tuple<T...> &value)
+    {
+        bindToTuple(value);
+    }
+
+    std::vector<std::string>::const_iterator match(std::vector<std::string>::const_iterator argument, std::vector<std::string>::const_iterator end)
+    {
+        return matchArgument(argument, end);
+    }
+
+private:
+    enum class Type
+    {
+        Undefined,
+        String,
+        Integer,
+        LongLong,
+        Double,
+        Bool,
+        IntegerList,
+        LongLongList,
+        DoubleList,
+        Tuple,
+        Blob,
+        View,
+        Lazy
+    };
+
+    enum : std::size_t
+    {
+        MaxArity = 16
+    };
+
+    class TupleValue
+    {
+    public:
+        virtual ~TupleValue() = default;
+        virtual std::size_t arity() const = 0;
+        virtual bool assign(const char *const *values, const Option &option) = 0;
+    };
+
+    template<typename Tuple>
+    class TupleBinding : public TupleValue
+    {
+    public:
+        explicit TupleBinding(Tuple &value) :
+            mValue(value)
+        {
+
+        }
+
+        std::size_t arity() const override
+        {
+            return std::tuple_size<Tuple>::value;
+        }
+
+        bool assign(const char *const *values, const Option &option) override
+        {
+            if(!check(values, Index<0>()))
+                return false;
+
+            set(values, option, Index<0>());
+            return true;
+        }
+
+    private:
+        template<std::size_t I> using Index = std::integral_constant<std::size_t, I>;
+        using End = Index<std::tuple_size<Tuple>::value>;
+
+        bool check(const char *const *, End) const { return true; }
+        template<std::size_t I> bool check(const char *const *values, Index<I>) const { return isElement(values[I], std::get<I>(mValue)) && check(values, Index<I + 1>()); }
+        void set(const char *const *, const Option &, End) {}
+        template<std::size_t I> void set(const char *const *values, const Option &option, Index<I>) { convert(values[I], std::get<I>(mValue), option); set(values, option, Index<I + 1>()); }
+
+        Tuple &mValue;
+    };
+
+    union DefaultValue
+    {
+        int i;
+        long long l;
+        double d;
+        bool b = false;
+    };
+
+    union ValueBinding
+    {
+        std::string *s;
+        int *i;
+        long long *l;
+        double *d;
+        std::vector<int> *il;
+        std::vector<long long> *ll;
+        std::vector<double> *dl;
+        LazyValue *z;
+        TupleValue *t;
+        cppcommandline::Blob *x;
+        StringView *v;
+        bool *b = nullptr;
+    };
+
+    struct KeyValue
+    {
+        const char *key = nullptr;
+        std::size_t keySize = 0;
+        const char *value = nullptr;
+        bool longName = false;
+    };
+
+    struct OptionPrivate
+    {
+        InternedString longName;
+        InternedString shortName;
+        InternedString description;
+        InternedString group;
+        std::string longNameCopy;
+        std::string shortNameCopy;
+        std::string descriptionCopy;
+        std::string groupCopy;
+        std::string defaultStringValue;
+        std::vector<std::string> choices;
+        std::vector<std::string> excludes;
+        std::vector<std::string> dependencies;
+        Option::DefaultValue defaultValue;
+        Option::DefaultValue minimum;
+        Option::DefaultValue maximum;
+        Option::ValueBinding valueBinding;
+        std::unique_ptr<TupleValue> tuple;
+        bool (*convert)(const char *value, Option::ValueBinding binding, const Option &option) = nullptr;
+        std::function<void(const CancellationToken &token)> action;
+        void (*actionRunner)(const Option &option, const std::function<void(std::function<void()> task)> &executor, CancellationToken &cancellation) = nullptr;
+        Option::Type type = Type::Undefined;
+        bool required = false;
+        bool defaulted = false;
+        bool ranged = false;
+        char listDelimiter = ',';
+        unsigned listThreads = 1;
+        bool lazy = false;
+        bool matched = false;
+        bool frozen = false;
+    };
+
+    template<typename T> T *getBoundValue() const;
+    template<typename T> T getDefaultValue() const;
+    template<typename T> void setDefault(T);
+    template<typename T> void setRange(T, T);
+    template<typename T> void setValueBinding(T*);
+    template<typename T> Type getType() const;
+
+    static void assign(InternedString &string, std::string &copy, const char *text, std::size_t size, bool copyText)
+    {
+        if(InternedString::Interner interner = InternedString::interner().load(std::memory_order_acquire))
+            string = interner(text, size, copyText);
+        else if(copyText)
+        {
+            copy.assign(text, size);
+            string = InternedString(0, copy.data(), size);
+        }
+        else
+            string = InternedString(0, text, size);
+    }
+
+    template<typename T> typename std::enable_if<!std::is_same<T, Blob>::value>::type setConverter(T *) {}
+    template<typename T> typename std::enable_if<std::is_same<T, Blob>::value>::type setConverter(T *) { d->convert = &convertBlob<T>; }
+    template<typename T> void setConverter(std::vector<T> *) { d->convert = &convertList<T>; }
+
+    static std::vector<int> *listBinding(ValueBinding binding, int *) { return binding.il; }
+    static std::vector<long long> *listBinding(ValueBinding binding, long long *) { return binding.ll; }
+    static std::vector<double> *listBinding(ValueBinding binding, double *) { return binding.dl; }
+
+    template<typename T>
+    static bool convertList(const char *value, ValueBinding binding, const Option &option)
+    {
+        return NumberList(option.d->listDelimiter, option.d->listThreads).parse(value, std::strlen(value), *listBinding(binding, static_cast<T*>(nullptr)));
+    }
+
+    template<typename T>
+    static bool convertBlob(const char *value, ValueBinding binding, const Option &)
+    {
+        return static_cast<T*>(binding.x)->assign(value, std::strlen(value));
+    }
+
+    static void runAction(const Option &option, const std::function<void(std::function<void()> task)> &executor, CancellationToken &cancellation)
+    {
+        if(!cancellation.mCancelled)
+            cancellation.mCancelled = std::make_shared<std::atomic<bool>>(false);
+
+        if(executor)
+        {
+            std::function<void(const CancellationToken &token)> action = option.d->action;
+            CancellationToken token = cancellation;
+            executor([action, token]() { action(token); });
+        }
+        else
+            option.d->action(cancellation);
+    }
+
+    template<typename Tuple>
+    void bindToTuple(Tuple &value)
+    {
+        static_assert(std::tuple_size<Tuple>::value > 0 && std::tuple_size<Tuple>::value <= MaxArity, "Options can take 1 to 16 values.");
+        checkNotFrozen();
+
+        if(isPositional())
+            throw std::logic_error("Positional arguments cannot be bound to multiple values.");
+        else if(d->lazy || (d->type != Type::Undefined && d->type != Type::Tuple))
+            throw std::logic_error("The option " + getName() + " has type (" + getTypeAsString(d->type) + ") and cannot be bound to multiple values.");
+
+        d->tuple.reset(new TupleBinding<Tuple>(value));
+        d->valueBinding.t = d->tuple.get();
+        d->type = Type::Tuple;
+    }
+
+    template<typename Iterator>
+    Iterator matchArgument(Iterator argument, Iterator end)
+    {
+        KeyValue keyValue = getKeyValue(toArgument(*argument));
+
+        if(!keyValue.key)
+        {
+            if(isPositional())
+                argument = matchPositional(argument);
+        }
+        else if(keyValue.longName ? isName(keyValue, d->longName) : isName(keyValue, d->shortName))
+            argument = matchNamed(keyValue, argument, end);
+
+        return argument;
+    }
+
+    template<typename Iterator>
+    Iterator matchPositional(Iterator argument)
+    {
+        return matchPositional(d->lazy ? Type::Lazy : d->type, d->valueBinding, *this, argument);
+    }
+
+    template<typename Iterator>
+    Iterator matchNamed(const KeyValue &keyValue, Iterator argument, Iterator end)
+    {
+        return matchNamed(d->lazy ? Type::Lazy : d->type, d->valueBinding, *this, keyValue, argument, end);
+    }
+
+    template<typename Iterator>
+    static Iterator matchPositional(Type type, ValueBinding binding, const Option &option, Iterator argument)
+    {
+        if(setValue(type, binding, toArgument(*argument), option))
+            ++argument;
+
+        return argument;
+    }
+
+    template<typename Iterator>
+    static Iterator matchNamed(Type type, ValueBinding binding, const Option &option, const KeyValue &keyValue, Iterator argument, Iterator end)
+    {
+        if(type == Type::Bool || (type == Type::Lazy && option.d->type == Type::Bool))
+        {
+            if(setValue(type, binding, keyValue.value, option))
+                ++argument;
+        }
+        else if(type == Type::Tuple)
+            argument = matchTuple(binding, option, keyValue, argument, end);
+        else if(*keyValue.value == '\0')
+        {
+            Iterator it = argument;
+            ++it;
+
+            if(it == end)
+                throw(std::logic_error("Missing value for option '" + (option.longName().empty() ? "[positional]" : option.longName()) + "'"));
+            else if(setValue(type, binding, toArgument(*it), option))
+                argument = ++it;
+        }
+        else if(setValue(type, binding, keyValue.value, option))
+            ++argument;
+
+        return argument;
+    }
+
+    template<typename Iterator>
+    static Iterator matchTuple(ValueBinding binding, const Option &option, const KeyValue &keyValue, Iterator argument, Iterator end)
+    {
+        const char *values[MaxArity];
+        const std::size_t arity = binding.t->arity();
+        std::size_t count = 0;
+        Iterator it = argument;
+        ++it;
+
+        if(*keyValue.value != '\0')
+            values[count++] = keyValue.value;
+
+        for(; count < arity && it != end; ++it)
+            values[count++] = toArgument(*it);
+
+        if(count < arity)
+            throw(std::logic_error("Missing value for option '" + option.longName() + "'"));
+        else if(binding.t->assign(values, option))
+            argument = it;
+
+        return argument;
+    }
+
+    static bool setValue(Type type, ValueBinding binding, const char *value, const Option &option)
+    {
+        bool result = true;
+
+        switch(type)
+        {
+        case Type::Bool:
+            *binding.b = true;
+            break;
+        case Type::Double:
+            if((result = isDouble(value)))
+                *binding.d = std::strtod(value, nullptr);
+            break;
+        case Type::Integer:
+            if((result = isNumber(value)))
+                *binding.i = toInt(value, option);
+            break;
+        case Type::LongLong:
+            if((result = isNumber(value)))
+                *binding.l = toLongLong(value, option);
+            break;
+        case Type::String:
+            binding.s->assign(value);
+            break;
+        case Type::IntegerList:
+        case Type::LongLongList:
+        case Type::DoubleList:
+        case Type::Blob:
+            result = option.d->convert(value, binding, option);
+            break;
+        case Type::View:
+            *binding.v = StringView(value, std::strlen(value));
+            break;
+        case Type::Lazy:
+            result = setLazyValue(option.d->type, *binding.z, value);
+            break;
+        case Type::Tuple:
+        case Type::Undefined:
+            throw(std::logic_error("Bind value undefined for option '" + (option.longName().empty() ? "[positional]" : option.longName()) + "'"));
+            break;
+        }
+
+        return result;
+    }
+
+    static bool setLazyValue(Type type, LazyValue &lazy, const char *value)
+    {
+        switch(type)
+        {
+        case Type::Double:
+            if(!isDouble(value))
+                return false;
+            break;
+        case Type::Integer:
+        case Type::LongLong:
+            if(!isNumber(value))
+                return false;
+            break;
+        default:
+            break;
+        }
+
+        lazy.mToken.assign(value);
+        lazy.mMatched = true;
+        lazy.mConverted = false;
+        return true;
+    }
+
+    template<typename Named> static void convert(const char *value, std::string &result, const Named &) { result.assign(value); }
+    template<typename Named> static void convert(const char *value, int &result, const Named &name) { result = toInt(value, name); }
+    template<typename Named> static void convert(const char *value, long long &result, const Named &name) { result = toLongLong(value, name); }
+    template<typename Named> static void convert(const char *value, double &result, const Named &) { result = std::strtod(value, nullptr); }
+    template<typename Named> static void convert(const char *, bool &result, const Named &) { result = true; }
+
+    static bool isElement(const char *, const std::string &) { return true; }
+    static bool isElement(const char *value, const int &) { return isNumber(value); }
+    static bool isElement(const char *value, const long long &) { return isNumber(value); }
+    static bool isElement(const char *value, const double &) { return isDouble(value); }
+
+    template<typename Named>
+    static int toInt(const char *value, const Named &option)
+    {
+        long long number = toLongLong(value, option);
+
+        if(number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max())
+            throw(std::out_of_range("The value '" + std::string(value) + "' is out of range for option " + nameOf(option) + "."));
+
+        return static_cast<int>(number);
+    }
+
+    template<typename Named>
+    static long long toLongLong(const char *value, const Named &option)
+    {
+        errno = 0;
+        long long number = std::strtoll(value, nullptr, 10);
+
+        if(errno == ERANGE)
+            throw(std::out_of_range("The value '" + std::string(value) + "' is out of range for option " + nameOf(option) + "."));
+
+        return number;
+    }
+
+    static std::string nameOf(const Option &option)
+    {
+        return option.getName();
+    }
+
+    static const std::string &nameOf(const std::string &name)
+    {
+        return name;
+    }
+
+    void checkNotFrozen() const
+    {
+        if(d->frozen)
+            throw std::logic_error("The option " + getName() + " cannot be changed after the parser was frozen.");
+    }
+
+    static std::string valueAsString(Type type, DefaultValue value)
+    {
+        char buffer[32] = "";
+
+        switch(type)
+        {
+        case Type::Bool: return value.b ? "true" : "false";
+        case Type::Double: std::snprintf(buffer, sizeof(buffer), "%g", value.d); break;
+        case Type::Integer: std::snprintf(buffer, sizeof(buffer), "%d", value.i); break;
+        case Type::LongLong: std::snprintf(buffer, sizeof(buffer), "%lld", value.l); break;
+        default: break;
+        }
+
+        return buffer;
+    }
+
+    static void checkValue(Type type, ValueBinding binding, const Option &option)
+    {
+        const OptionPrivate &d = *option.d;
+        DefaultValue value;
+
+        if(type != Type::String && !d.ranged)
+            return;
+
+        switch(type)
+        {
+        case Type::Double:
+            if(!binding.d || (*binding.d >= d.minimum.d && *binding.d <= d.maximum.d))
+                return;
+            value.d = *binding.d;
+            break;
+        case Type::Integer:
+            if(!binding.i || (*binding.i >= d.minimum.i && *binding.i <= d.maximum.i))
+                return;
+            value.i = *binding.i;
+            break;
+        case Type::LongLong:
+            if(!binding.l || (*binding.l >= d.minimum.l && *binding.l <= d.maximum.l))
+                return;
+            value.l = *binding.l;
+            break;
+        case Type::String:
+        {
+            if(!binding.s || d.choices.empty() || std::find(d.choices.cbegin(), d.choices.cend(), *binding.s) != d.choices.cend())
+                return;
+
+            std::string choices;
+
+            for(const std::string &choice : d.choices)
+                choices += (choices.empty() ? "" : ", ") + choice;
+
+            throw std::logic_error("Value '" + *binding.s + "' of option " + option.getName() + " is not one of: " + choices);
+        }
+        default:
+            return;
+        }
+
+        throw std::logic_error("Value " + valueAsString(type, value) + " of option " + option.getName() + " is out of range [" + valueAsString(type, d.minimum) + ", " + valueAsString(type, d.maximum) + "]");
+    }
+
+    void checkDefaultValue() const
+    {
+        ValueBinding binding;
+
+        if(!d->defaulted)
+            return;
+
+        switch(d->type)
+        {
+        case Type::Double: binding.d = &d->defaultValue.d; break;
+        case Type::Integer: binding.i = &d->defaultValue.i; break;
+        case Type::LongLong: binding.l = &d->defaultValue.l; break;
+        case Type::String: binding.s = &d->defaultStringValue; break;
+        default: return;
+        }
+
+        checkValue(d->type, binding, *this);
+    }
+
+    std::string getName() const
+    {
+        return d->longName.empty() ? "[Positional]" : "'" + d->longName + "'";
+    }
+
+    std::string getTypeAsString(Type type) const
+    {
+        std::string val = "Undefined";
+
+        switch(type)
+        {
+        case Type::Bool: val = "bool"; break;
+        case Type::Double: val = "double"; break;
+        case Type::Integer: val = "int"; break;
+        case Type::LongLong: val = "long long"; break;
+        case Type::String: val = "string"; break;
+        case Type::IntegerList: val = "int list"; break;
+        case Type::LongLongList: val = "long long list"; break;
+        case Type::DoubleList: val = "double list"; break;
+        case Type::Tuple: val = "tuple"; break;
+        case Type::Blob: val = "blob"; break;
+        case Type::View: val = "string view"; break;
+        case Type::Lazy: val = "lazy"; break;
+        case Type::Undefined: break;
+        }
+
+        return val;
+    }
+
+    static const char *toArgument(const std::string &argument)
+    {
+        return argument.c_str();
+    }
+
+    static const char *toArgument(const char *argument)
+    {
+        return argument;
+    }
+
+    static bool isAlpha(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    static bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isAlphaNumeric(char c)
+    {
+        return isAlpha(c) || isDigit(c);
+    }
+
+    static bool isName(const KeyValue &keyValue, const InternedString &name)
+    {
+        return keyValue.keySize == name.size() && std::memcmp(keyValue.key, name.data(), name.size()) == 0;
+    }
+
+    static KeyValue getKeyValue(const char *argument)
+    {
+        KeyValue keyValue;
+        const char *key = argument;
+
+        if(*key == '-')
+        {
+            ++key;
+
+            if(*key == '-' && isAlpha(key[1]))
+                ++key;
+        }
+
+        if(key != argument && isAlpha(*key))
+        {
+            const char *keyEnd = key + 1;
+
+            while(isAlphaNumeric(*keyEnd))
+                ++keyEnd;
+
+            if(*keyEnd == '\0' || *keyEnd == '=')
+            {
+                keyValue.key = key;
+                keyValue.keySize = static_cast<std::size_t>(keyEnd - key);
+                keyValue.value = *keyEnd == '=' ? keyEnd + 1 : keyEnd;
+                keyValue.longName = key - argument == 2;
+                return keyValue;
+            }
+        }
+
+        keyValue.value = argument;
+        return keyValue;
+    }
+
+    bool defaultTypeCompatibleWithBoundType(Type defaultType, Type boundType) const
+    {
+        return defaultType != Type::Undefined && boundType != Type::Undefined && (defaultType == boundType || (defaultType == Type::Integer && boundType == Type::LongLong));
+    }
+
+    void setBoundType(Type boundType)
+    {
+        if(d->type == Type::Undefined)
+            d->type = boundType;
+        else if(!defaultTypeCompatibleWithBoundType(d->type, boundType))
+            throw std::logic_error("The option " + getName() + " has default value set with incompatible type (" + getTypeAsString(d->type) + ") to the one it is being bound to (" + getTypeAsString(boundType) + ")" );
+        else if(d->type == Type::Integer && boundType == Type::LongLong)
+        {
+            d->defaultValue.l = d->defaultValue.i;
+            d->minimum.l = d->minimum.i;
+            d->maximum.l = d->maximum.i;
+            d->type = Type::LongLong;
+        }
+    }
+
+    static bool isDouble(const char *argument)
+    {
+        if(*argument == '-')
+            ++argument;
+
+        if(!isDigit(*argument))
+            return false;
+
+        while(isDigit(*argument))
+            ++argument;
+
+        if(*argument++ != '.' || !isDigit(*argument))
+            return false;
+
+        while(isDigit(*argument))
+            ++argument;
+
+        return *argument == '\0';
+    }
+
+    static bool isNumber(const char *argument)
+    {
+        if(*argument == '-')
+            ++argument;
+
+        if(!isDigit(*argument))
+            return false;
+
+        while(isDigit(*argument))
+            ++argument;
+
+        return *argument == '\0';
+    }
+
+    static bool isLongName(const char *longName, std::size_t size)
+    {
+        return size != 0 && std::all_of(longName, longName + size, isAlphaNumeric);
+    }
+
+    static bool isShortName(const std::string &shortName)
+    {
+        return shortName.size() == 1 && isAlphaNumeric(shortName[0]);
+    }
+
+    std::unique_ptr<OptionPrivate> d;
+
+    friend class Parser;
+    friend class Dispatcher;
+    friend class Settings;
+    friend class ParseServer;
+    friend class HelpIndex;
+    template<typename T> friend class Lazy;
+};
+
+template<> inline std::string *Option::getBoundValue() const { return d->valueBinding.s; }
+template<> inline int *Option::getBoundValue() const { return d->valueBinding.i; }
+template<> inline long long *Option::getBoundValue() const { return d->valueBinding.l; }
+template<> inline double *Option::getBoundValue() const { return d->valueBinding.d; }
+template<> inline bool *Option::getBoundValue() const { return d->valueBinding.b; }
+template<> inline std::vector<int> *Option::getBoundValue() const { return d->valueBinding.il; }
+template<> inline std::vector<long long> *Option::getBoundValue() const { return d->valueBinding.ll; }
+template<> inline std::vector<double> *Option::getBoundValue() const { return d->valueBinding.dl; }
+template<> inline Blob *Option::getBoundValue() const { return d->valueBinding.x; }
+template<> inline StringView *Option::getBoundValue() const { return d->valueBinding.v; }
+template<> inline std::string Option::getDefaultValue() const { return d->defaultStringValue; }
+template<> inline int Option::getDefaultValue() const { return d->defaultValue.i; }
+template<> inline long long Option::getDefaultValue() const { return d->defaultValue.l; }
+template<> inline double Option::getDefaultValue() const { return d->defaultValue.d; }
+template<> inline bool Option::getDefaultValue() const { return d->defaultValue.b; }
+template<> inline void Option::setDefault(std::string defaultValue) { d->defaultStringValue = defaultValue; }
+template<> inline void Option::setDefault(int defaultValue) { d->defaultValue.i = defaultValue; }
+template<> inline void Option::setDefault(long long defaultValue) { d->defaultValue.l = defaultValue; }
+template<> inline void Option::setDefault(double defaultValue) { d->defaultValue.d = defaultValue; }
+template<> inline void Option::setDefault(bool defaultValue) { d->defaultValue.b = defaultValue; }
+template<> inline void Option::setRange(int minimum, int maximum) { d->minimum.i = minimum; d->maximum.i = maximum; }
+template<> inline void Option::setRange(long long minimum, long long maximum) { d->minimum.l = minimum; d->maximum.l = maximum; }
+template<> inline void Option::setRange(double minimum, double maximum) { d->minimum.d = minimum; d->maximum.d = maximum; }
+template<> inline void Option::setValueBinding(std::string *binding) { d->valueBinding.s = binding; if(d->defaulted) *binding = d->defaultStringValue; }
+template<> inline void Option::setValueBinding(int *binding) { d->valueBinding.i = binding; if(d->defaulted) *binding = d->defaultValue.i; }
+template<> inline void Option::setValueBinding(long long *binding) { d->valueBinding.l = binding; if(d->defaulted) *binding = d->defaultValue.l; }
+template<> inline void Option::setValueBinding(double *binding) { d->valueBinding.d = binding; if(d->defaulted) *binding = d->defaultValue.d; }
+template<> inline void Option::setValueBinding(bool *binding) { d->valueBinding.b = binding; if(d->defaulted) *binding = d->defaultValue.b; }
+template<> inline void Option::setValueBinding(std::vector<int> *binding) { d->valueBinding.il = binding; }
+template<> inline void Option::setValueBinding(std::vector<long long> *binding) { d->valueBinding.ll = binding; }
+template<> inline void Option::setValueBinding(std::vector<double> *binding) { d->valueBinding.dl = binding; }
+template<> inline void Option::setValueBinding(Blob *binding) { d->valueBinding.x = binding; }
+template<> inline void Option::setValueBinding(StringView *binding) { d->valueBinding.v = binding; }
+template<> inline Option::Type Option::getType<std::string>() const { return Type::String; }
+template<> inline Option::Type Option::getType<int>() const { return Type::Integer; }
+template<> inline Option::Type Option::getType<long long>() const { return Type::LongLong; }
+template<> inline Option::Type Option::getType<bool>() const { return Type::Bool; }
+template<> inline Option::Type Option::getType<double>() const { return Type::Double; }
+template<> inline Option::Type Option::getType<std::vector<int>>() const { return Type::IntegerList; }
+template<> inline Option::Type Option::getType<std::vector<long long>>() const { return Type::LongLongList; }
+template<> inline Option::Type Option::getType<std::vector<double>>() const { return Type::DoubleList; }
+template<> inline Option::Type Option::getType<Blob>() const { return Type::Blob; }
+template<> inline Option::Type Option::getType<StringView>() const { return Type::View; }
+
+template<typename T>
+class Lazy : public LazyValue
+{
+public:
+    Lazy() = default;
+
+    const T &value() const
+    {
+        if(!mConverted)
+        {
+            Option::convert(mToken.c_str(), mValue, mName);
+            mConverted = true;
+        }
+
+        return mValue;
+    }
+
+    operator const T &() const
+    {
+        return value();
+    }
+
+private:
+    mutable T mValue = T();
+
+    friend class Option;
+};
+
+class ArgumentScanner
+{
+public:
+    struct Token
+    {
+        char *data = nullptr;
+        std::size_t size = 0;
+    };
+
+    explicit ArgumentScanner(char separator = '\0') :
+        mSeparator(separator)
+    {
+
+    }
+
+    char separator() const
+    {
+        return mSeparator;
+    }
+
+    void scan(char *blob, std::size_t size, std::vector<Token> &tokens) const
+    {
+        tokens.clear();
+        Token token;
+        token.data = blob;
+        std::size_t offset = 0;
+
+#ifdef CPPCOMMANDLINE_AVX2
+        if(hasAvx2())
+            offset = scanAvx2(blob, size, tokens, token);
+#endif
+#ifdef CPPCOMMANDLINE_SSE2
+        offset += scanSse2(blob + offset, size - offset, tokens, token);
+#endif
+
+        for(char *at = blob + offset; at != blob + size; ++at)
+        {
+            if(*at == mSeparator)
+                addToken(at, tokens, token);
+        }
+
+        if(token.data != blob + size)
+        {
+            token.size = static_cast<std::size_t>(blob + size - token.data);
+            tokens.push_back(token);
+        }
+    }
+
+private:
+
+    static unsigned lowestBit(std::uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long bit = 0;
+        _BitScanForward(&bit, mask);
+        return static_cast<unsigned>(bit);
+#elif defined(__GNUC__)
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+        unsigned bit = 0;
+
+        while(!(mask & 1))
+        {
+            mask >>= 1;
+            ++bit;
+        }
+
+        return bit;
+#endif
+    }
+
+    static void addToken(char *separator, std::vector<Token> &tokens, Token &token)
+    {
+        *separator = '\0';
+        token.size = static_cast<std::size_t>(separator - token.data);
+        tokens.push_back(token);
+        token = Token();
+        token.data = separator + 1;
+    }
+
+    static void addSeparators(char *block, std::uint32_t separators, std::vector<Token> &tokens, Token &token)
+    {
+        for(; separators; separators &= separators - 1)
+            addToken(block + lowestBit(separators), tokens, token);
+    }
+
+#ifdef CPPCOMMANDLINE_SSE2
+    std::size_t scanSse2(char *blob, std::size_t size, std::vector<Token> &tokens, Token &token) const
+    {
+        const __m128i separator = _mm_set1_epi8(mSeparator);
+        std::size_t offset = 0;
+
+        for(; offset + 16 <= size; offset += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blob + offset));
+            std::uint32_t separators = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, separator)));
+
+            if(separators)
+                addSeparators(blob + offset, separators, tokens, token);
+        }
+
+        return offset;
+    }
+#endif
+
+#ifdef CPPCOMMANDLINE_AVX2
+    static bool hasAvx2()
+    {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    __attribute__((target("avx2"))) std::size_t scanAvx2(char *blob, std::size_t size, std::vector<Token> &tokens, Token &token) const
+    {
+        const __m256i separator = _mm256_set1_epi8(mSeparator);
+        std::size_t offset = 0;
+
+        for(; offset + 32 <= size; offset += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blob + offset));
+            std::uint32_t separators = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, separator)));
+
+            if(separators)
+                addSeparators(blob + offset, separators, tokens, token);
+        }
+
+        return offset;
+    }
+#endif
+
+    char mSeparator;
+};
+
+class ArgumentReader
+{
+public:
+    template<typename Stream, typename Count = decltype(std::declval<Stream&>().gcount())>
+    explicit ArgumentReader(Stream &stream, char separator = '\0', std::size_t chunkSize = 65536) :
+        mRead([&stream](char *buffer, std::size_t size) { stream.read(buffer, static_cast<Count>(size)); return static_cast<std::size_t>(stream.gcount()); }),
+        mChunk(chunkSize),
+        mSeparator(separator)
+    {
+
+    }
+
+    explicit ArgumentReader(int fileDescriptor, char separator = '\0', std::size_t chunkSize = 65536) :
+        mRead([fileDescriptor](char *buffer, std::size_t size) { return readFile(fileDescriptor, buffer, size); }),
+        mChunk(chunkSize),
+        mSeparator(separator)
+    {
+
+    }
+
+    char *next()
+    {
+        std::string &token = mTokens[mToken ^= 1];
+        token.clear();
+        bool partial = false;
+
+        while(!mEnd)
+        {
+            if(mBegin == mSize)
+            {
+                mBegin = 0;
+                mSize = mRead(mChunk.data(), mChunk.size());
+                mEnd = mSize == 0;
+                continue;
+            }
+
+            const char *begin = mChunk.data() + mBegin;
+            const char *separator = static_cast<const char*>(std::memchr(begin, mSeparator, mSize - mBegin));
+
+            if(separator)
+            {
+                token.append(begin, separator);
+                mBegin += static_cast<std::size_t>(separator - begin) + 1;
+                return &token[0];
+            }
+
+            token.append(begin, mSize - mBegin);
+            mBegin = mSize;
+            partial = true;
+        }
+
+        return partial ? &token[0] : nullptr;
+    }
+
+private:
+    static std::size_t readFile(int fileDescriptor, char *buffer, std::size_t size)
+    {
+        for(;;)
+        {
+#ifdef _WIN32
+            int count = _read(fileDescriptor, buffer, static_cast<unsigned>(size));
+#else
+            ssize_t count = ::read(fileDescriptor, buffer, size);
+#endif
+
+            if(count >= 0)
+                return static_cast<std::size_t>(count);
+            else if(errno != EINTR)
+                throw std::runtime_error("Reading command line arguments failed: " + std::string(std::strerror(errno)));
+        }
+    }
+
+    std::function<std::size_t(char*, std::size_t)> mRead;
+    std::vector<char> mChunk;
+    std::string mTokens[2];
+    std::size_t mBegin = 0;
+    std::size_t mSize = 0;
+    int mToken = 0;
+    char mSeparator;
+    bool mEnd = false;
+};
+
+template<typename T>
+class Setting
+{
+public:
+    std::size_t index() const
+    {
+        return mIndex;
+    }
+
+private:
+    explicit Setting(std::uint32_t index) :
+        mIndex(index)
+    {
+
+    }
+
+    std::uint32_t mIndex;
+
+    friend class Parser;
+};
+
+class Settings
+{
+public:
+    template<typename T>
+    const T &value(Setting<T> setting) const
+    {
+        return get<T>(mValues[setting.index()]);
+    }
+
+    template<typename T>
+    bool isMatched(Setting<T> setting) const
+    {
+        return mMatched[setting.index()];
+    }
+
+private:
+    struct Value
+    {
+        Option::DefaultValue number;
+        std::string string;
+        std::vector<int> integers;
+        std::vector<long long> longLongs;
+        std::vector<double> doubles;
+    };
+
+    template<typename T> static const T &get(const Value &value);
+
+    std::vector<Value> mValues;
+    std::vector<bool> mMatched;
+
+    friend class Parser;
+    friend class ParseServer;
+};
+
+template<> inline const std::string &Settings::get(const Value &value) { return value.string; }
+template<> inline const int &Settings::get(const Value &value) { return value.number.i; }
+template<> inline const long long &Settings::get(const Value &value) { return value.number.l; }
+template<> inline const double &Settings::get(const Value &value) { return value.number.d; }
+template<> inline const bool &Settings::get(const Value &value) { return value.number.b; }
+template<> inline const std::vector<int> &Settings::get(const Value &value) { return value.integers; }
+template<> inline const std::vector<long long> &Settings::get(const Value &value) { return value.longLongs; }
+template<> inline const std::vector<double> &Settings::get(const Value &value) { return value.doubles; }
+
+class SettingsPublisher
+{
+public:
+    class Reader
+    {
+    public:
+        explicit Reader(SettingsPublisher &publisher) :
+            mPublisher(publisher)
+        {
+            std::lock_guard<std::mutex> lock(mPublisher.mMutex);
+            mEpoch.store(mPublisher.mEpoch.load());
+            mPublisher.mReaders.push_back(this);
+        }
+
+        Reader(const Reader &other) = delete;
+        Reader &operator=(const Reader &other) = delete;
+
+        ~Reader()
+        {
+            std::lock_guard<std::mutex> lock(mPublisher.mMutex);
+            mPublisher.mReaders.erase(std::find(mPublisher.mReaders.begin(), mPublisher.mReaders.end(), this));
+        }
+
+        const Settings *current() const
+        {
+            return mPublisher.current();
+        }
+
+        void quiescent()
+        {
+            mEpoch.store(mPublisher.mEpoch.load());
+        }
+
+    private:
+        SettingsPublisher &mPublisher;
+        std::atomic<std::uint64_t> mEpoch{0};
+
+        friend class SettingsPublisher;
+    };
+
+    SettingsPublisher() = default;
+    SettingsPublisher(const SettingsPublisher &other) = delete;
+    SettingsPublisher &operator=(const SettingsPublisher &other) = delete;
+
+    ~SettingsPublisher()
+    {
+        delete mCurrent.load();
+    }
+
+    const Settings *current() const
+    {
+        return mCurrent.load(std::memory_order_acquire);
+    }
+
+    void publish(std::unique_ptr<Settings> settings)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const Settings *previous = mCurrent.exchange(settings.release());
+        const std::uint64_t epoch = mEpoch.fetch_add(1) + 1;
+
+        if(previous)
+            mRetired.emplace_back(epoch, std::unique_ptr<const Settings>(previous));
+
+        reclaimRetired();
+    }
+
+    void reclaim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        reclaimRetired();
+    }
+
+    std::size_t retiredCount() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mRetired.size();
+    }
+
+private:
+    void reclaimRetired()
+    {
+        std::uint64_t safe = mEpoch.load();
+
+        for(const Reader *reader : mReaders)
+            safe = std::min(safe, reader->mEpoch.load());
+
+        mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), [&](const std::pair<std::uint64_t, std::unique_ptr<const Settings>> &retired) { return retired.first <= safe; }), mRetired.end());
+    }
+
+    std::atomic<const Settings*> mCurrent{nullptr};
+    std::atomic<std::uint64_t> mEpoch{0};
+    mutable std::mutex mMutex;
+    std::vector<Reader*> mReaders;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<const Settings>>> mRetired;
+};
+
+class SchemaArena
+{
+public:
+    explicit SchemaArena(std::size_t size)
+    {
+#ifdef _WIN32
+        mSize = size;
+        mData = static_cast<char*>(::operator new(size));
+#else
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        mSize = (size + page - 1) / page * page;
+        void *data = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if(data == MAP_FAILED)
+            throw std::bad_alloc();
+
+        mData = static_cast<char*>(data);
+#endif
+    }
+
+    SchemaArena(const SchemaArena &other) = delete;
+    SchemaArena &operator=(const SchemaArena &other) = delete;
+
+    ~SchemaArena()
+    {
+#ifdef _WIN32
+        ::operator delete(mData);
+#else
+        ::munmap(mData, mSize);
+#endif
+    }
+
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        const std::size_t offset = (mUsed + alignment - 1) / alignment * alignment;
+
+        if(offset > mSize || mSize - offset < size)
+            return nullptr;
+
+        mUsed = offset + size;
+        return mData + offset;
+    }
+
+    bool contains(const void *data) const
+    {
+        return data >= mData && data < mData + mSize;
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    bool protect()
+    {
+#ifdef _WIN32
+        return false;
+#else
+        return ::mprotect(mData, mSize, PROT_READ) == 0;
+#endif
+    }
+
+private:
+    char *mData = nullptr;
+    std::size_t mSize = 0;
+    std::size_t mUsed = 0;
+};
+
+template<typename T>
+class SchemaAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    SchemaAllocator() = default;
+
+    explicit SchemaAllocator(SchemaArena *arena) :
+        mArena(arena)
+    {
+
+    }
+
+    template<typename U>
+    SchemaAllocator(const SchemaAllocator<U> &other) :
+        mArena(other.mArena)
+    {
+
+    }
+
+    T *allocate(std::size_t count)
+    {
+        void *data = mArena ? mArena->allocate(count * sizeof(T), alignof(T)) : nullptr;
+        return static_cast<T*>(data ? data : ::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T *data, std::size_t)
+    {
+        if(!mArena || !mArena->contains(data))
+            ::operator delete(data);
+    }
+
+    template<typename U>
+    bool operator==(const SchemaAllocator<U> &other) const
+    {
+        return mArena == other.mArena;
+    }
+
+    template<typename U>
+    bool operator!=(const SchemaAllocator<U> &other) const
+    {
+        return mArena != other.mArena;
+    }
+
+private:
+    SchemaArena *mArena = nullptr;
+
+    template<typename U> friend class SchemaAllocator;
+};
+
+template<typename T>
+using SchemaVector = std::vector<T, SchemaAllocator<T>>;
+
+class Parser
+{
+public:
+    void setOutput(std::function<void(const std::string &text)> output)
+    {
+        mOutput = std::move(output);
+    }
+
+    void setExecutor(std::function<void(std::function<void()> task)> executor)
+    {
+        mExecutor = std::move(executor);
+    }
+
+    bool helpEnabled() const
+    {
+        return mHelp;
+    }
+
+    void disableHelp()
+    {
+        mHelp = false;
+    }
+
+    enum class Passthrough
+    {
+        Disabled,
+        AfterTerminator,
+        FromFirstUnmatched
+    };
+
+    Passthrough passthrough() const
+    {
+        return mPassthrough;
+    }
+
+    void setPassthrough(Passthrough passthrough)
+    {
+        mPassthrough = passthrough;
+        mMatchPassthrough = passthrough == Passthrough::Disabled ? nullptr : &Parser::matchPassthrough;
+    }
+
+    char **passthroughArguments() const
+    {
+        return mState->passthroughArguments;
+    }
+
+    int passthroughCount() const
+    {
+        return static_cast<int>(mState->passthroughEnd - mState->passthroughArguments);
+    }
+
+    bool abbreviationsEnabled() const
+    {
+        return mAbbreviations;
+    }
+
+    void enableAbbreviations()
+    {
+        mAbbreviations = true;
+    }
+
+    std::string command() const
+    {
+        return mState->command;
+    }
+
+    std::string applicationName() const
+    {
+        return applicationName(*mState);
+    }
+
+    bool helpDisplayed() const
+    {
+        return mState->helpDisplayed;
+    }
+
+    bool isFrozen() const
+    {
+        return mFrozen;
+    }
+
+    Option &option()
+    {
+        checkNotFrozen();
+        mOptions.emplace_back(Option());
+        return mOptions.back();
+    }
+
+    Option &option(std::string longName)
+    {
+        checkNotFrozen();
+        mOptions.emplace_back(Option(longName));
+        return mOptions.back();
+    }
+
+    Option &option(StringLiteral longName)
+    {
+        checkNotFrozen();
+        mOptions.emplace_back(Option(longName));
+        return mOptions.back();
+    }
+
+    void finalize()
+    {
+        if(mFrozen)
+            return;
+
+        validateSchema();
+        mPositionals.clear();
+        mShortNames.assign(128, static_cast<std::uint32_t>(NoOption));
+        mTypes.clear();
+        mBindings.clear();
+        mFlags.clear();
+        mRequired = 0;
+        std::vector<std::uint32_t> named;
+
+        for(std::uint32_t i = 0; i < mOptions.size(); i++)
+        {
+            const Option::OptionPrivate &option = *mOptions[i].d;
+            mTypes.push_back(option.type);
+            mBindings.push_back(option.valueBinding);
+            mFlags.push_back(static_cast<std::uint8_t>((option.required ? RequiredFlag : 0) | (option.lazy ? LazyFlag : 0)));
+            mRequired += option.required ? 1 : 0;
+
+            if(option.longName.empty())
+                mPositionals.push_back(i);
+            else
+            {
+                named.push_back(i);
+
+                if(!option.shortName.empty() && mShortNames[static_cast<unsigned char>(option.shortName[0])] == NoOption)
+                    mShortNames[static_cast<unsigned char>(option.shortName[0])] = i;
+            }
+        }
+
+        for(mNameSeed = 0; !buildNameHash(named); ++mNameSeed)
+        {
+        }
+
+        for(Option &option : mOptions)
+            option.d->frozen = true;
+
+        buildSortedNames();
+        compileConstraints();
+        packSchema();
+        mFrozen = true;
+        prepareState(*mState);
+    }
+
+    void freeze()
+    {
+        finalize();
+    }
+
+    void protectSchema()
+    {
+        if(!mFrozen)
+            throw std::logic_error("Only the schema of a frozen parser can be protected.");
+        else if(!mSchema->protect())
+            throw std::runtime_error("The schema of the parser cannot be protected.");
+    }
+
+    std::size_t schemaSize() const
+    {
+        return mSchema ? mSchema->size() : 0;
+    }
+
+    void parse(char *blob, std::size_t size, char separator = '\0')
+    {
+        if(size != 0 && blob[size - 1] != separator)
+            throw(std::logic_error("The argument blob must end with a separator"));
+
+        ArgumentScanner(separator).scan(blob, size, mState->tokens);
+        mState->blobArguments.clear();
+
+        for(const ArgumentScanner::Token &token : mState->tokens)
+            mState->blobArguments.push_back(token.data);
+
+        mState->blobArguments.push_back(nullptr);
+        parse(static_cast<int>(mState->tokens.size()), mState->blobArguments.data());
+    }
+
+    void parse(int argc, char **argv)
+    {
+        parse(argc, argv, mBindings, *mState);
+    }
+
+    void parse(ArgumentReader &reader)
+    {
+        if(mPassthrough != Passthrough::Disabled)
+            throw std::logic_error("Passthrough is not supported when parsing from an ArgumentReader.");
+
+        for(const Option &option : mOptions)
+        {
+            if(option.d->type == Option::Type::View)
+                throw std::logic_error("The option " + option.getName() + " is bound to a string view and cannot be parsed from an ArgumentReader.");
+            else if(option.d->type == Option::Type::Tuple)
+                throw std::logic_error("The option " + option.getName() + " takes multiple values and cannot be parsed from an ArgumentReader.");
+        }
+
+        try
+        {
+            mState->helpDisplayed = false;
+            char *window[2] = {reader.next(), nullptr};
+
+            if(window[0])
+                window[1] = reader.next();
+
+            beginParse(*mState);
+
+            while(window[0])
+            {
+                if(mHelp && isHelpArgument(window[0]))
+                {
+                    displayHelp(window[0], *mState);
+                    return;
+                }
+
+                if(matchArgument(window, window + (window[1] ? 2 : 1), mBindings, *mState) == window + 1)
+                {
+                    window[0] = window[1];
+                    window[1] = window[0] ? reader.next() : nullptr;
+                }
+                else
+                {
+                    window[0] = reader.next();
+                    window[1] = window[0] ? reader.next() : nullptr;
+                }
+            }
+
+            endParse(mBindings, *mState);
+        }
+        catch(std::logic_error &e)
+        {
+            cancelActions(*mState);
+            reportError(e, *mState);
+            throw e;
+        }
+    }
+
+    std::unique_ptr<Settings> parseSettings(int argc, char **argv)
+    {
+        return parseSettings(argc, argv, *mState);
+    }
+
+    template<typename T>
+    Setting<T> setting(const std::string &longName)
+    {
+        auto option = std::find_if(mOptions.begin(), mOptions.end(), [&](const Option &candidate) { return candidate.d->longName == longName; });
+
+        if(longName.empty() || option == mOptions.end())
+            throw std::logic_error("There is no option '" + longName + "'.");
+
+        return setting<T>(*option);
+    }
+
+    template<typename T>
+    Setting<T> setting(Option &option)
+    {
+        checkNotFrozen();
+        auto it = std::find_if(mOptions.cbegin(), mOptions.cend(), [&](const Option &other) { return other.d == option.d; });
+
+        if(it == mOptions.cend())
+            throw std::logic_error("The option " + option.getName() + " does not belong to this parser.");
+
+        option.setBoundType(option.getType<T>());
+
+        return Setting<T>(static_cast<std::uint32_t>(it - mOptions.cbegin()));
+    }
+
+private:
+    struct NameSlot
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t option = NoOption;
+    };
+
+    enum : std::uint32_t
+    {
+        NoOption = 0xFFFFFFFF
+    };
+
+    enum : std::uint8_t
+    {
+        RequiredFlag = 1,
+        LazyFlag = 2
+    };
+
+    class HelpSearch
+    {
+    public:
+        virtual ~HelpSearch() = default;
+        virtual void build(const std::vector<Option> &options) = 0;
+        virtual std::vector<std::uint32_t> find(const char *term) const = 0;
+    };
+
+    struct Constraint
+    {
+        std::uint32_t option = NoOption;
+        std::size_t masks = 0;
+    };
+
+    struct ParseState
+    {
+        std::string command;
+        std::size_t appNameBegin = 0;
+        std::size_t appNameSize = 0;
+        std::vector<ArgumentScanner::Token> tokens;
+        std::vector<char*> blobArguments;
+        std::vector<std::uint32_t> matched;
+        std::uint32_t generation = 0;
+        std::size_t requiredMatched = 0;
+        std::vector<std::uint64_t> presence;
+        bool helpDisplayed = false;
+        char **passthroughArguments = nullptr;
+        char **passthroughEnd = nullptr;
+        CancellationToken cancellation;
+        std::string *output = nullptr;
+    };
+
+    std::unique_ptr<Settings> parseSettings(int argc, char **argv, ParseState &state)
+    {
+        freeze();
+
+        std::unique_ptr<Settings> settings(new Settings);
+        settings->mValues.resize(mOptions.size());
+        SchemaVector<Option::ValueBinding> bindings(mOptions.size());
+
+        for(std::size_t i = 0; i < mOptions.size(); i++)
+        {
+            Settings::Value &value = settings->mValues[i];
+            value.number = mOptions[i].d->defaultValue;
+            value.string = mOptions[i].d->defaultStringValue;
+
+            switch(mTypes[i])
+            {
+            case Option::Type::Bool: bindings[i].b = &value.number.b; break;
+            case Option::Type::Double: bindings[i].d = &value.number.d; break;
+            case Option::Type::Integer: bindings[i].i = &value.number.i; break;
+            case Option::Type::LongLong: bindings[i].l = &value.number.l; break;
+            case Option::Type::String: bindings[i].s = &value.string; break;
+            case Option::Type::IntegerList: bindings[i].il = &value.integers; break;
+            case Option::Type::LongLongList: bindings[i].ll = &value.longLongs; break;
+            case Option::Type::DoubleList: bindings[i].dl = &value.doubles; break;
+            case Option::Type::Tuple: throw std::logic_error("The option " + mOptions[i].getName() + " is bound to multiple values and cannot be parsed into settings.");
+            case Option::Type::Blob:
+            case Option::Type::View: throw std::logic_error("The option " + mOptions[i].getName() + " is bound to a caller buffer and cannot be parsed into settings.");
+            case Option::Type::Lazy:
+            case Option::Type::Undefined: break;
+            }
+        }
+
+        parse(argc, argv, bindings, state);
+        settings->mMatched.resize(mOptions.size());
+
+        for(std::size_t i = 0; i < mOptions.size(); i++)
+            settings->mMatched[i] = state.matched[i] == state.generation;
+
+        return settings;
+    }
+
+    void parse(int argc, char **argv, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        try
+        {
+            state.helpDisplayed = false;
+
+            if(argc == 0)
+                throw(std::logic_error("Missing mandatory first command line argument"));
+            else
+                setCommand(argv[0], state);
+
+            char **begin = argv + 1;
+            char **end = argv + argc;
+            state.passthroughArguments = end;
+            state.passthroughEnd = end;
+
+            if(mHelp && !mMatchPassthrough)
+            {
+                char **help = std::find_if(begin, end, isHelpArgument);
+
+                if(help != end)
+                {
+                    displayHelp(*help, state);
+                    return;
+                }
+            }
+
+            beginParse(state);
+
+            for(char **arg = begin; arg != end;)
+            {
+                char **next = mMatchPassthrough ? (this->*mMatchPassthrough)(arg, end, bindings, state) : findMatch(arg, end, bindings, state);
+
+                if(!next)
+                    return;
+                else if(next == arg)
+                    throw unmatchedArgument(*arg);
+
+                arg = next;
+            }
+
+            endParse(bindings, state);
+        }
+        catch(std::logic_error &e)
+        {
+            cancelActions(state);
+            reportError(e, state);
+            throw e;
+        }
+    }
+
+    char **matchPassthrough(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        if(std::strcmp(*arg, "--") == 0)
+        {
+            state.passthroughArguments = arg + 1;
+            return end;
+        }
+        else if(mHelp && isHelpArgument(*arg))
+        {
+            displayHelp(*arg, state);
+            return nullptr;
+        }
+
+        char **next = findMatch(arg, end, bindings, state);
+
+        if(next == arg && mPassthrough == Passthrough::FromFirstUnmatched && !Option::getKeyValue(*arg).key)
+        {
+            state.passthroughArguments = arg;
+            return end;
+        }
+
+        return next;
+    }
+
+    std::string applicationName(const ParseState &state) const
+    {
+        return state.command.substr(state.appNameBegin, state.appNameSize);
+    }
+
+    void setCommand(const char *command, ParseState &state)
+    {
+        state.command.assign(command);
+        std::size_t separator = state.command.find_last_of("\\/");
+        state.appNameBegin = separator == std::string::npos ? 0 : separator + 1;
+        state.appNameSize = state.command.size() - state.appNameBegin;
+
+        if(state.appNameSize >= 4 && state.command.compare(state.command.size() - 4, 4, ".exe") == 0)
+            state.appNameSize -= 4;
+    }
+
+    static bool isHelpArgument(const char *argument)
+    {
+        return std::strcmp(argument, "--help") == 0 || std::strcmp(argument, "-h") == 0 || std::strncmp(argument, "--help=", 7) == 0;
+    }
+
+    void displayHelp(const char *argument, ParseState &state)
+    {
+        const char *term = mHelpSearch ? helpTerm(argument) : nullptr;
+        const std::vector<std::uint32_t> options = helpOptions(term);
+        write(formatHelp(options, helpHeading(term, options.empty()), state), state);
+        state.helpDisplayed = true;
+    }
+
+    static const char *helpTerm(const char *argument)
+    {
+        const char *term = std::strchr(argument, '=');
+        return term && term[1] ? term + 1 : nullptr;
+    }
+
+    static std::string helpHeading(const char *term, bool empty)
+    {
+        if(!term)
+            return "Options:\n";
+        else if(empty)
+            return "No options match '" + std::string(term) + "'.\n";
+        else
+            return "Options matching '" + std::string(term) + "':\n";
+    }
+
+    std::vector<std::uint32_t> helpOptions(const char *term)
+    {
+        std::vector<std::uint32_t> options;
+
+        if(term && mHelpSearch)
+        {
+            buildHelpIndex();
+            options = mHelpSearch->find(term);
+        }
+        else
+        {
+            for(std::uint32_t i = 0; i < mOptions.size(); i++)
+                options.push_back(i);
+        }
+
+        return options;
+    }
+
+    std::string formatHelp(const std::vector<std::uint32_t> &options, const std::string &heading, const ParseState &state) const
+    {
+        return "Usage: " + applicationName(state) + " [options]\n" + heading + formatOptions(options) + "\n";
+    }
+
+    std::string formatOptions(const std::vector<std::uint32_t> &options) const
+    {
+        std::string help;
+        std::vector<InternedString> groups;
+
+        for(std::uint32_t index : options)
+        {
+            const InternedString &group = mOptions[index].d->group;
+
+            if(group.empty())
+                help += helpEntry(mOptions[index]);
+            else if(std::find(groups.cbegin(), groups.cend(), group) == groups.cend())
+                groups.push_back(group);
+        }
+
+        for(const InternedString &group : groups)
+        {
+            help += "\n" + group + ":\n";
+
+            for(std::uint32_t index : options)
+            {
+                if(mOptions[index].d->group == group)
+                    help += helpEntry(mOptions[index]);
+            }
+        }
+
+        return help;
+    }
+
+    static std::string helpEntry(const Option &option)
+    {
+        std::string entry;
+
+        if(option.isPositional())
+            entry += padded("    [positional]", 25);
+        else
+            entry += padded("    -" + option.shortName() + ", --" + option.longName(), 25);
+
+        if(option.isRequired())
+            entry += padded("[required]", 20);
+        else if(option.hasDefaultValue())
+            entry += padded("[default=" + option.defaultValueAsString() + "]", 20);
+        else
+            entry += padded("[optional]", 20);
+
+        return entry + option.description() + "\n";
+    }
+
+    void buildHelpIndex()
+    {
+        if(mHelpSearch && (!mFrozen || !mHelpIndexed))
+        {
+            mHelpSearch->build(mOptions);
+            mHelpIndexed = mFrozen;
+        }
+    }
+
+    void reportError(const std::logic_error &e, ParseState &state) const
+    {
+        std::string error = "Error parsing command line arguments: " + std::string(e.what()) + "\n";
+
+        if(mHelp)
+            error += "Use --help or -h to list the command line options.\n";
+
+        write(error, state);
+    }
+
+    static std::string padded(std::string text, std::size_t width)
+    {
+        if(text.size() < width)
+            text.append(width - text.size(), ' ');
+
+        return text;
+    }
+
+    void write(const std::string &text) const
+    {
+        if(mOutput)
+            mOutput(text);
+        else
+        {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            std::fflush(stdout);
+        }
+    }
+
+    void write(const std::string &text, ParseState &state) const
+    {
+        if(state.output)
+            *state.output += text;
+        else
+            write(text);
+    }
+
+    void beginParse(ParseState &state)
+    {
+        state.cancellation.mCancelled.reset();
+
+        if(mFrozen)
+            nextGeneration(state);
+        else
+        {
+            for(Option &option : mOptions)
+                option.d->matched = false;
+
+            compileConstraints();
+            state.presence.assign(mConstraints.empty() ? 0 : (mOptions.size() + 63) / 64, 0);
+        }
+    }
+
+    char **matchArgument(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        char **next = findMatch(arg, end, bindings, state);
+
+        if(next == arg)
+            throw unmatchedArgument(*arg);
+
+        return next;
+    }
+
+    char **findMatch(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        char **next = mFrozen ? matchFrozen(arg, end, bindings, state) : match(arg, end, state);
+
+        if(next == arg && mAbbreviations)
+            next = matchAbbreviation(arg, end, bindings, state);
+
+        return next;
+    }
+
+    std::logic_error unmatchedArgument(const char *argument)
+    {
+        return std::logic_error("No option matches argument '" + std::string(argument) + "'" + suggestion(argument));
+    }
+
+    void endParse(const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        for(std::size_t i = mFrozen && state.requiredMatched == mRequired ? mOptions.size() : 0; i < mOptions.size(); i++)
+        {
+            if(mFrozen ? (mFlags[i] & RequiredFlag) && state.matched[i] != state.generation : !mOptions[i].d->matched && mOptions[i].isRequired())
+                throw(std::logic_error("Option '" + (mOptions[i].longName().empty() ? "[positional]" : mOptions[i].longName())  + "' was set as required but did not match any arguments"));
+        }
+
+        if(!mConstraints.empty())
+            checkConstraints(state);
+
+        for(std::uint32_t index : mValueChecks)
+        {
+            if(mFrozen ? state.matched[index] == state.generation : mOptions[index].d->matched)
+                Option::checkValue(mFrozen ? mTypes[index] : mOptions[index].d->type, mFrozen ? bindings[index] : mOptions[index].d->valueBinding, mOptions[index]);
+        }
+    }
+
+    void compileConstraints()
+    {
+        const std::size_t words = (mOptions.size() + 63) / 64;
+        mConstraints.clear();
+        mConstraintMasks.clear();
+        mValueChecks.clear();
+
+        auto find = [&](const std::string &longName, const Option &option) -> std::uint32_t
+        {
+            auto it = std::find_if(mOptions.cbegin(), mOptions.cend(), [&](const Option &other) { return other.d->longName == longName; });
+
+            if(longName.empty() || it == mOptions.cend())
+                throw std::logic_error("The option " + option.getName() + " refers to an unknown option '" + longName + "'.");
+
+            return static_cast<std::uint32_t>(it - mOptions.cbegin());
+        };
+
+        for(std::uint32_t i = 0; i < mOptions.size(); i++)
+        {
+            const Option::OptionPrivate &option = *mOptions[i].d;
+
+            if(option.ranged || !option.choices.empty())
+                mValueChecks.push_back(i);
+
+            if(option.excludes.empty() && option.dependencies.empty())
+                continue;
+
+            Constraint constraint;
+            constraint.option = i;
+            constraint.masks = mConstraintMasks.size();
+            mConstraintMasks.resize(mConstraintMasks.size() + 2 * words, 0);
+
+            for(const std::string &name : option.excludes)
+            {
+                std::uint32_t other = find(name, mOptions[i]);
+                mConstraintMasks[constraint.masks + other / 64] |= std::uint64_t(1) << (other % 64);
+            }
+
+            for(const std::string &name : option.dependencies)
+            {
+                std::uint32_t other = find(name, mOptions[i]);
+                mConstraintMasks[constraint.masks + words + other / 64] |= std::uint64_t(1) << (other % 64);
+            }
+
+            mConstraints.push_back(constraint);
+        }
+    }
+
+    void prepareState(ParseState &state) const
+    {
+        state.matched.assign(mOptions.size(), 0);
+        state.generation = 0;
+        state.presence.assign(mConstraints.empty() ? 0 : (mOptions.size() + 63) / 64, 0);
+    }
+
+    void checkConstraints(ParseState &state)
+    {
+        const std::size_t words = state.presence.size();
+
+        if(!mFrozen)
+        {
+            for(std::uint32_t i = 0; i < mOptions.size(); i++)
+            {
+                if(mOptions[i].d->matched)
+                    state.presence[i / 64] |= std::uint64_t(1) << (i % 64);
+            }
+        }
+
+        for(const Constraint &constraint : mConstraints)
+        {
+            if(!(state.presence[constraint.option / 64] & (std::uint64_t(1) << (constraint.option % 64))))
+                continue;
+
+            const std::uint64_t *excluded = &mConstraintMasks[constraint.masks];
+            const std::uint64_t *dependencies = excluded + words;
+
+            for(std::size_t word = 0; word < words; word++)
+            {
+                if(std::uint64_t conflict = state.presence[word] & excluded[word])
+                    throw std::logic_error("Option '" + mOptions[constraint.option].longName() + "' cannot be used together with '" + mOptions[word * 64 + lowestBit(conflict)].longName() + "'");
+
+                if(std::uint64_t missing = dependencies[word] & ~state.presence[word])
+                    throw std::logic_error("Option '" + mOptions[constraint.option].longName() + "' requires '" + mOptions[word * 64 + lowestBit(missing)].longName() + "'");
+            }
+        }
+    }
+
+    static std::size_t lowestBit(std::uint64_t word)
+    {
+        std::size_t bit = 0;
+
+        while(!(word & 1))
+        {
+            word >>= 1;
+            ++bit;
+        }
+
+        return bit;
+    }
+
+    char **matchAbbreviation(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        Option::KeyValue keyValue = Option::getKeyValue(*arg);
+
+        if(!keyValue.key || !keyValue.longName)
+            return arg;
+
+        if(!mFrozen)
+            buildSortedNames();
+
+        auto name = [&](std::uint32_t index) -> const InternedString & { return mOptions[index].d->longName; };
+        auto first = std::lower_bound(mSortedNames.cbegin(), mSortedNames.cend(), keyValue, [&](std::uint32_t index, const Option::KeyValue &key) { return name(index).compare(0, std::string::npos, key.key, key.keySize) < 0; });
+        auto isCandidate = [&](SchemaVector<std::uint32_t>::const_iterator it) { return it != mSortedNames.cend() && name(*it).compare(0, keyValue.keySize, keyValue.key, keyValue.keySize) == 0; };
+
+        if(!isCandidate(first))
+            return arg;
+
+        auto other = first;
+
+        while(isCandidate(other) && name(*other) == name(*first))
+            ++other;
+
+        if(isCandidate(other))
+        {
+            std::string candidates = "--" + name(*first);
+
+            for(auto it = other; isCandidate(it); ++it)
+            {
+                if(name(*it) != name(*(it - 1)))
+                    candidates += ", --" + name(*it);
+            }
+
+            throw(std::logic_error("Ambiguous option '" + std::string(*arg) + "' could be: " + candidates));
+        }
+
+        const std::uint32_t index = *first;
+        char **next = arg;
+
+        if(mFrozen)
+        {
+            if(state.matched[index] != state.generation)
+            {
+                next = Option::matchNamed(bindingType(index, bindings), bindings[index], mOptions[index], keyValue, arg, end);
+
+                if(next != arg)
+                {
+                    setMatched(index, state);
+                    runAction(mOptions[index], bindings, state);
+                }
+            }
+        }
+        else if(!mOptions[index].d->matched)
+        {
+            next = mOptions[index].matchNamed(keyValue, arg, end);
+
+            if((mOptions[index].d->matched = next != arg))
+                runAction(mOptions[index], mBindings, state);
+        }
+
+        return next;
+    }
+
+    void buildSortedNames()
+    {
+        mSortedNames.clear();
+
+        for(std::uint32_t i = 0; i < mOptions.size(); i++)
+        {
+            if(!mOptions[i].isPositional())
+                mSortedNames.push_back(i);
+        }
+
+        std::stable_sort(mSortedNames.begin(), mSortedNames.end(), [&](std::uint32_t left, std::uint32_t right) { return mOptions[left].d->longName < mOptions[right].d->longName; });
+    }
+
+    struct SuggestionName
+    {
+        std::uint64_t signature = 0;
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        bool longName = false;
+    };
+
+    struct SuggestionVariant
+    {
+        std::uint32_t hash = 0;
+        std::uint32_t name = 0;
+    };
+
+    std::string suggestion(const char *argument)
+    {
+        Option::KeyValue keyValue = Option::getKeyValue(argument);
+
+        if(!keyValue.key || keyValue.keySize > 64)
+            return std::string();
+
+        if(!mFrozen || !mSuggestionsIndexed)
+            buildSuggestionIndex();
+
+        std::uint64_t peq[128] = {};
+
+        for(std::size_t i = 0; i < keyValue.keySize; i++)
+            peq[static_cast<unsigned char>(keyValue.key[i]) & 127] |= std::uint64_t(1) << i;
+
+        const std::uint64_t signature = nameSignature(keyValue.key, keyValue.keySize);
+        std::size_t best = std::min(std::max<std::size_t>(1, keyValue.keySize / 3) + 1, keyValue.keySize);
+        const SuggestionName *match = nullptr;
+
+        auto consider = [&](const SuggestionName &name) {
+            const std::size_t sizeDifference = name.size > keyValue.keySize ? name.size - keyValue.keySize : keyValue.keySize - name.size;
+
+            if(sizeDifference >= best || std::max(bitCount(signature & ~name.signature), bitCount(name.signature & ~signature)) >= best)
+                return;
+
+            const std::size_t distance = editDistance(peq, keyValue.keySize, mSuggestionTable.data() + name.offset, name.size);
+
+            if(distance < best && (distance != 0 || name.longName != keyValue.longName))
+            {
+                best = distance;
+                match = &name;
+            }
+        };
+
+        for(std::size_t skip = 0; skip <= keyValue.keySize; skip++)
+        {
+            SuggestionVariant variant;
+            variant.hash = variantHash(keyValue.key, keyValue.keySize, skip);
+            auto range = std::equal_range(mSuggestionVariants.cbegin(), mSuggestionVariants.cend(), variant, [](const SuggestionVariant &left, const SuggestionVariant &right) { return left.hash < right.hash; });
+
+            for(auto it = range.first; it != range.second; ++it)
+                consider(mSuggestionNames[it->name]);
+        }
+
+        if(!match)
+            return std::string();
+
+        return ". Did you mean '" + std::string(match->longName ? "--" : "-") + mSuggestionTable.substr(match->offset, match->size) + "'?";
+    }
+
+    void buildSuggestionIndex()
+    {
+        mSuggestionTable.clear();
+        mSuggestionNames.clear();
+        mSuggestionVariants.clear();
+
+        for(const Option &option : mOptions)
+        {
+            for(const InternedString *name : {&option.d->longName, &option.d->shortName})
+            {
+                if(name->empty() || name->size() > 64)
+                    continue;
+
+                SuggestionName suggestion;
+                suggestion.signature = nameSignature(name->data(), name->size());
+                suggestion.offset = static_cast<std::uint32_t>(mSuggestionTable.size());
+                suggestion.size = static_cast<std::uint32_t>(name->size());
+                suggestion.longName = name == &option.d->longName;
+                mSuggestionNames.push_back(suggestion);
+                mSuggestionTable.append(name->data(), name->size());
+            }
+        }
+
+        for(std::uint32_t i = 0; i < mSuggestionNames.size(); i++)
+        {
+            const SuggestionName &name = mSuggestionNames[i];
+
+            for(std::size_t skip = 0; skip <= name.size; skip++)
+            {
+                SuggestionVariant variant;
+                variant.hash = variantHash(mSuggestionTable.data() + name.offset, name.size, skip);
+                variant.name = i;
+                mSuggestionVariants.push_back(variant);
+            }
+        }
+
+        std::sort(mSuggestionVariants.begin(), mSuggestionVariants.end(), [](const SuggestionVariant &left, const SuggestionVariant &right) { return left.hash < right.hash; });
+        mSuggestionsIndexed = mFrozen;
+    }
+
+    static std::uint32_t variantHash(const char *name, std::size_t size, std::size_t skip)
+    {
+        std::uint32_t hash = 2166136261u;
+
+        for(std::size_t i = 0; i < size; i++)
+        {
+            if(i != skip)
+            {
+                hash ^= static_cast<unsigned char>(name[i]);
+                hash *= 16777619u;
+            }
+        }
+
+        return hash;
+    }
+
+    static std::uint64_t nameSignature(const char *name, std::size_t size)
+    {
+        std::uint64_t signature = 0;
+
+        for(std::size_t i = 0; i < size; i++)
+            signature |= std::uint64_t(1) << (static_cast<unsigned char>(name[i]) & 63);
+
+        return signature;
+    }
+
+    static std::size_t bitCount(std::uint64_t bits)
+    {
+#ifdef __GNUC__
+        return static_cast<std::size_t>(__builtin_popcountll(bits));
+#else
+        std::size_t count = 0;
+
+        for(; bits; bits &= bits - 1)
+            ++count;
+
+        return count;
+#endif
+    }
+
+    static std::size_t editDistance(const std::uint64_t *peq, std::size_t patternSize, const char *text, std::size_t textSize)
+    {
+        const std::uint64_t last = std::uint64_t(1) << (patternSize - 1);
+        std::uint64_t pv = ~std::uint64_t(0);
+        std::uint64_t mv = 0;
+        std::size_t distance = patternSize;
+
+        for(std::size_t i = 0; i < textSize; i++)
         {
-        if(argc == 0)
-            throw(std::logic_error("Missing mandatory first command line argument"));
-        else
+            const std::uint64_t eq = peq[static_cast<unsigned char>(text[i]) & 127];
+            const std::uint64_t xv = eq | mv;
+            const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            std::uint64_t ph = mv | ~(xh | pv);
+            std::uint64_t mh = pv & xh;
+
+            if(ph & last)
+                ++distance;
+            else if(mh & last)
+                --distance;
+
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+        }
+
+        return distance;
+    }
+
+    void checkNotFrozen() const
+    {
+        if(mFrozen)
+            throw std::logic_error("Options cannot be added after the parser was frozen.");
+    }
+
+    void nextGeneration(ParseState &state)
+    {
+        if(++state.generation == 0)
+        {
+            std::fill(state.matched.begin(), state.matched.end(), 0);
+            state.generation = 1;
+        }
+
+        state.requiredMatched = 0;
+        std::fill(state.presence.begin(), state.presence.end(), 0);
+    }
+
+    void runAction(const Option &option, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        if(option.d->actionRunner && &bindings == &mBindings)
+            option.d->actionRunner(option, mExecutor, state.cancellation);
+    }
+
+    void cancelActions(ParseState &state)
+    {
+        if(state.cancellation.mCancelled)
+            state.cancellation.mCancelled->store(true, std::memory_order_release);
+    }
+
+    void validateSchema() const
+    {
+        std::vector<std::pair<InternedString, std::uint32_t>> longNames;
+        std::vector<std::pair<InternedString, std::uint32_t>> shortNames;
+        std::string errors;
+        std::size_t positionals = 0;
+        bool optionalPositional = false;
+
+        for(std::uint32_t i = 0; i < mOptions.size(); i++)
         {
-            mCommand = argv[0];
-            std::cmatch m;
-            if(std::regex_search(mCommand.c_str(), m, std::regex("[^\\\\\\/]+$")))
+            const Option::OptionPrivate &option = *mOptions[i].d;
+
+            if(option.longName.empty())
             {
-                mAppName = m[0];
+                ++positionals;
 
-                if(std::regex_search(mAppName.c_str(), std::regex("\\.exe$")))
-                    mAppName.erase(mAppName.size() - 4, 4);
+                if(option.required && optionalPositional)
+                    errors += "The required positional argument " + std::to_string(positionals) + " follows an optional one. ";
+
+                optionalPositional = optionalPositional || !option.required;
+                continue;
             }
+
+            longNames.emplace_back(option.longName, i);
+
+            if(!option.shortName.empty())
+                shortNames.emplace_back(option.shortName, i);
+
+            if(mHelp && (option.longName == "help" || option.shortName == "h"))
+                errors += "The option '" + option.longName + "' is shadowed by the help option. ";
         }
 
-        mArgs = std::vector<std::string>();
+        findDuplicates(longNames, true, errors);
+        findDuplicates(shortNames, false, errors);
 
-        for(int i = 1; i < argc; i++)
-            mArgs.emplace_back(argv[i]);
+        if(!errors.empty())
+            throw std::logic_error(errors.substr(0, errors.size() - 1));
+    }
 
-        if(mHelp)
+    void findDuplicates(std::vector<std::pair<InternedString, std::uint32_t>> &names, bool longNames, std::string &errors) const
+    {
+        std::sort(names.begin(), names.end());
+
+        for(std::size_t i = 1; i < names.size(); i++)
+        {
+            if(names[i].first == names[i - 1].first && (i + 1 == names.size() || names[i + 1].first != names[i].first))
+            {
+                const Option::OptionPrivate &option = *mOptions[names[i].second].d;
+                errors += longNames ? "The name '--" + option.longName + "' is declared by more than one option. "
+                                    : "The name '-" + option.shortName + "' is declared by more than one option. ";
+            }
+        }
+    }
+
+    void packSchema()
+    {
+        const std::size_t size = packedSize(mNameTable) + packedSize(mNameSlots) + packedSize(mDisplacements) + packedSize(mShortNames)
+            + packedSize(mPositionals) + packedSize(mSortedNames) + packedSize(mTypes) + packedSize(mBindings) + packedSize(mFlags)
+            + packedSize(mConstraints) + packedSize(mConstraintMasks) + packedSize(mValueChecks);
+
+        mSchema.reset(new SchemaArena(size));
+        pack(mNameTable);
+        pack(mNameSlots);
+        pack(mDisplacements);
+        pack(mShortNames);
+        pack(mPositionals);
+        pack(mSortedNames);
+        pack(mTypes);
+        pack(mBindings);
+        pack(mFlags);
+        pack(mConstraints);
+        pack(mConstraintMasks);
+        pack(mValueChecks);
+    }
+
+    template<typename T>
+    static std::size_t packedSize(const SchemaVector<T> &table)
+    {
+        return table.size() * sizeof(T) + alignof(T);
+    }
+
+    template<typename T>
+    void pack(SchemaVector<T> &table)
+    {
+        table = SchemaVector<T>(table.cbegin(), table.cend(), SchemaAllocator<T>(mSchema.get()));
+    }
+
+    void setMatched(std::uint32_t index, ParseState &state)
+    {
+        state.matched[index] = state.generation;
+
+        if(mFlags[index] & RequiredFlag)
+            ++state.requiredMatched;
+
+        if(!state.presence.empty())
+            state.presence[index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+    char **match(char **arg, char **end, ParseState &state)
+    {
+        for(Option &option : mOptions)
         {
-            std::vector<std::string> helpNames = {"--help", "-h"};
+            if(option.d->matched)
+                continue;
 
-            if(std::find_first_of(mArgs.cbegin(), mArgs.cend(), helpNames.cbegin(), helpNames.cend()) != mArgs.cend())
+            char **next = option.matchArgument(arg, end);
+
+            if(next != arg)
             {
-                std::cout << "Usage: " << mAppName << " [options]" << std::endl;
-                std::cout << "Options:" << std::endl;
+                option.d->matched = true;
+                runAction(option, mBindings, state);
+                return next;
+            }
+        }
 
-                for (const Option& option : mOptions)
-                {
-                    {
-                    std::ostringstream str;
+        return arg;
+    }
 
-                    if(option.isPositional())
-                        str << "    [positional]";
-                    else
-                        str << "    -" << option.shortName() << ", --" << option.longName();
+    char **matchFrozen(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        Option::KeyValue keyValue = Option::getKeyValue(*arg);
 
-                    std::cout << std::left << std::setw(25) << str.str();
-                    }
+        if(keyValue.key)
+        {
+            std::uint32_t index = keyValue.longName ? findLongName(keyValue.key, keyValue.keySize) : (keyValue.keySize == 1 ? mShortNames[static_cast<unsigned char>(*keyValue.key)] : NoOption);
+            return index == NoOption ? arg : matchNamedOption(index, keyValue, arg, end, bindings, state);
+        }
+        else
+            return matchPositionals(arg, bindings, state);
+    }
 
-                    {
-                    std::ostringstream str;
+    Option::Type bindingType(std::uint32_t index, const SchemaVector<Option::ValueBinding> &bindings) const
+    {
+        return (mFlags[index] & LazyFlag) && &bindings == &mBindings ? Option::Type::Lazy : mTypes[index];
+    }
 
-                    if(option.isRequired())
-                        str << "[required]";
-                    else if(option.hasDefaultValue())
-                        str << "[default=" << option.defaultValueAsString() << "]";
-                    else
-                        str << "[optional]";
+    char **matchNamedOption(std::uint32_t index, const Option::KeyValue &keyValue, char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        if(state.matched[index] == state.generation)
+            return arg;
 
-                    std::cout << std::setw(20) << str.str() << option.description() << std::endl;
-                    }
-                }
+        char **next = Option::matchNamed(bindingType(index, bindings), bindings[index], mOptions[index], keyValue, arg, end);
 
-                std::cout << std::endl;
-                mHelpDisplayed = true;
-                return;
+        if(next != arg)
+        {
+            setMatched(index, state);
+            runAction(mOptions[index], bindings, state);
+        }
+
+        return next;
+    }
+
+    char **matchPositionals(char **arg, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state)
+    {
+        for(std::uint32_t index : mPositionals)
+        {
+            if(state.matched[index] == state.generation)
+                continue;
+
+            char **next = Option::matchPositional(bindingType(index, bindings), bindings[index], mOptions[index], arg);
+
+            if(next != arg)
+            {
+                setMatched(index, state);
+                runAction(mOptions[index], bindings, state);
+                return next;
             }
         }
 
-        std::vector<Option*> options;
+        return arg;
+    }
+
+    static std::uint64_t hashName(const char *name, std::size_t size, std::uint64_t seed)
+    {
+        std::uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
 
-        for(Option &option : mOptions)
-            options.emplace_back(&option);
+        for(std::size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(name[i]);
+            hash *= 1099511628211ull;
+        }
+
+        return hash ^ (hash >> 29);
+    }
+
+    static std::size_t nameSlot(std::uint64_t hash, std::int32_t displacement, std::size_t size)
+    {
+        return static_cast<std::size_t>(((hash >> 32) ^ ((static_cast<std::uint64_t>(displacement) * 0x9E3779B97F4A7C15ull) >> 32)) % size);
+    }
+
+    std::uint32_t findLongName(const char *name, std::size_t size) const
+    {
+        if(mNameSlots.empty())
+            return NoOption;
+
+        std::uint64_t hash = hashName(name, size, mNameSeed);
+        std::int32_t displacement = mDisplacements[static_cast<std::uint32_t>(hash) % mDisplacements.size()];
+        const NameSlot &slot = mNameSlots[displacement < 0 ? static_cast<std::size_t>(-displacement - 1) : nameSlot(hash, displacement, mNameSlots.size())];
+        return slot.size == size && std::memcmp(mNameTable.data() + slot.offset, name, size) == 0 ? slot.option : NoOption;
+    }
+
+    bool buildNameHash(const std::vector<std::uint32_t> &named)
+    {
+        mNameTable.clear();
+        std::vector<NameSlot> names;
+        std::vector<std::uint32_t> sorted(named);
+        std::stable_sort(sorted.begin(), sorted.end(), [&](std::uint32_t left, std::uint32_t right) { return mOptions[left].d->longName < mOptions[right].d->longName; });
+
+        for(std::size_t i = 0; i < sorted.size(); i++)
+        {
+            const std::uint32_t index = sorted[i];
+            const InternedString &name = mOptions[index].d->longName;
+
+            if(i != 0 && name == mOptions[sorted[i - 1]].d->longName)
+                continue;
+
+            NameSlot slot;
+            slot.offset = static_cast<std::uint32_t>(mNameTable.size());
+            slot.size = static_cast<std::uint32_t>(name.size());
+            slot.option = index;
+            names.push_back(slot);
+            mNameTable.insert(mNameTable.end(), name.data(), name.data() + name.size());
+        }
+
+        const std::size_t size = names.size();
+        mNameSlots.assign(size, NameSlot());
+        mDisplacements.assign(size, 0);
+        std::vector<std::vector<std::uint32_t>> buckets(size);
+        std::vector<std::uint64_t> hashes(size);
 
-        for(auto arg = mArgs.cbegin(); arg != mArgs.cend();)
+        for(std::uint32_t i = 0; i < size; i++)
         {
-            auto start = arg;
+            hashes[i] = hashName(mNameTable.data() + names[i].offset, names[i].size, mNameSeed);
+            buckets[static_cast<std::uint32_t>(hashes[i]) % size].push_back(i);
+        }
+
+        std::vector<std::uint32_t> order(size);
+
+        for(std::uint32_t i = 0; i < size; i++)
+            order[i] = i;
+
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t left, std::uint32_t right) { return buckets[left].size() > buckets[right].size(); });
+        std::vector<bool> occupied(size, false);
+        std::vector<std::size_t> candidates;
+        std::size_t freeSlot = 0;
 
-            for(auto option = options.begin(); option != options.end();)
+        for(std::uint32_t bucket : order)
+        {
+            if(buckets[bucket].empty())
+                break;
+            else if(buckets[bucket].size() == 1)
             {
-                auto next = (*option)->match(arg, mArgs.cend());
+                while(occupied[freeSlot])
+                    ++freeSlot;
 
-                if(next != arg)
+                occupied[freeSlot] = true;
+                mNameSlots[freeSlot] = names[buckets[bucket][0]];
+                mDisplacements[bucket] = -static_cast<std::int32_t>(freeSlot) - 1;
+                continue;
+            }
+
+            std::int32_t displacement = 1;
+
+            for(; displacement < 0x10000; displacement++)
+            {
+                candidates.clear();
+
+                for(std::uint32_t name : buckets[bucket])
                 {
-                    option = options.erase(option);
-                    arg = next;
-                    break;
+                    std::size_t slot = nameSlot(hashes[name], displacement, size);
+
+                    if(occupied[slot] || std::find(candidates.cbegin(), candidates.cend(), slot) != candidates.cend())
+                        break;
+
+                    candidates.push_back(slot);
                 }
-                else
-                    ++option;
+
+                if(candidates.size() == buckets[bucket].size())
+                    break;
+            }
+
+            if(displacement == 0x10000)
+                return false;
+
+            for(std::size_t i = 0; i < candidates.size(); i++)
+            {
+                occupied[candidates[i]] = true;
+                mNameSlots[candidates[i]] = names[buckets[bucket][i]];
             }
 
-            if(arg == start)
-                throw(std::logic_error("No option matches argument '" + *arg + "'"));
+            mDisplacements[bucket] = displacement;
         }
 
-        for(Option *option : options)
+        return true;
+    }
+
+    std::unique_ptr<ParseState> mState = std::unique_ptr<ParseState>(new ParseState);
+    std::unique_ptr<SchemaArena> mSchema;
+    std::vector<Option> mOptions;
+    SchemaVector<char> mNameTable;
+    SchemaVector<NameSlot> mNameSlots;
+    SchemaVector<std::int32_t> mDisplacements;
+    SchemaVector<std::uint32_t> mShortNames;
+    SchemaVector<std::uint32_t> mPositionals;
+    SchemaVector<std::uint32_t> mSortedNames;
+    SchemaVector<Option::Type> mTypes;
+    SchemaVector<Option::ValueBinding> mBindings;
+    SchemaVector<std::uint8_t> mFlags;
+    std::size_t mRequired = 0;
+    SchemaVector<Constraint> mConstraints;
+    SchemaVector<std::uint64_t> mConstraintMasks;
+    SchemaVector<std::uint32_t> mValueChecks;
+    std::string mSuggestionTable;
+    std::vector<SuggestionName> mSuggestionNames;
+    std::vector<SuggestionVariant> mSuggestionVariants;
+    bool mSuggestionsIndexed = false;
+    std::uint64_t mNameSeed = 0;
+    bool mFrozen = false;
+    bool mAbbreviations = false;
+    bool mHelp = true;
+    Passthrough mPassthrough = Passthrough::Disabled;
+    char **(Parser::*mMatchPassthrough)(char **arg, char **end, const SchemaVector<Option::ValueBinding> &bindings, ParseState &state) = nullptr;
+    std::function<void(const std::string &text)> mOutput;
+    std::function<void(std::function<void()> task)> mExecutor;
+    std::unique_ptr<HelpSearch> mHelpSearch;
+    bool mHelpIndexed = false;
+
+    friend class Dispatcher;
+    friend class ParseServer;
+    friend class HelpIndex;
+};
+
+class Dispatcher
+{
+public:
+    void setOutput(std::function<void(const std::string &text)> output)
+    {
+        mOutput = std::move(output);
+    }
+
+    bool helpDisplayed() const
+    {
+        return mHelpDisplayed;
+    }
+
+    void add(Parser &parser)
+    {
+        if(std::find(mParsers.cbegin(), mParsers.cend(), &parser) != mParsers.cend())
+            throw std::logic_error("The parser is already registered.");
+
+        parser.freeze();
+        const std::uint32_t owner = static_cast<std::uint32_t>(mParsers.size());
+        std::vector<Route> routes;
+        std::uint32_t positionalOwner = mPositionalOwner;
+
+        for(std::uint32_t i = 0; i < parser.mOptions.size(); i++)
         {
-            if(option->isRequired())
-                throw(std::logic_error("Option '" + (option->longName().empty() ? "[positional]" : option->longName())  + "' was set as required but did not match any arguments"));
+            const Option::OptionPrivate &option = *parser.mOptions[i].d;
+
+            if(option.longName.empty())
+            {
+                if(positionalOwner != NoRoute && positionalOwner != owner)
+                    throw std::logic_error("Positional arguments are already declared by another parser.");
+
+                positionalOwner = owner;
+                continue;
+            }
+
+            if(findRoute(option.longName.data(), option.longName.size()))
+                throw std::logic_error("Option '--" + option.longName + "' is already declared by another parser.");
+            else if(!option.shortName.empty() && mShortNames[static_cast<unsigned char>(option.shortName[0])].parser != NoRoute)
+                throw std::logic_error("Option '-" + option.shortName + "' is already declared by another parser.");
+
+            Route added;
+            added.parser = owner;
+            added.option = i;
+            routes.push_back(added);
         }
+
+        mParsers.push_back(&parser);
+        mPositionalOwner = positionalOwner;
+
+        for(const Route &route : routes)
+        {
+            const Option::OptionPrivate &option = *parser.mOptions[route.option].d;
+
+            if(!findRoute(option.longName.data(), option.longName.size()))
+                addRoute(route);
+
+            if(!option.shortName.empty() && mShortNames[static_cast<unsigned char>(option.shortName[0])].parser == NoRoute)
+                mShortNames[static_cast<unsigned char>(option.shortName[0])] = route;
         }
-        catch(std::logic_error &e)
+    }
+
+    void parse(int argc, char **argv)
+    {
+        try
         {
-            std::cout << "Error parsing command line arguments: " << e.what() << std::endl;
+            if(argc == 0)
+                throw(std::logic_error("Missing mandatory first command line argument"));
+
+            char **begin = argv + 1;
+            char **end = argv + argc;
+
+            mHelpDisplayed = false;
+
+            for(Parser *parser : mParsers)
+            {
+                parser->mState->helpDisplayed = false;
+                parser->setCommand(argv[0], *parser->mState);
+            }
+
+            if(helpEnabled())
+            {
+                char **help = std::find_if(begin, end, [this](const char *argument) { return Parser::isHelpArgument(argument) && !findRoute(Option::getKeyValue(argument)); });
+
+                if(help != end)
+                {
+                    displayHelp(*help);
+                    return;
+                }
+            }
+
+            for(Parser *parser : mParsers)
+                parser->beginParse(*parser->mState);
+
+            for(char **arg = begin; arg != end;)
+            {
+                Option::KeyValue keyValue = Option::getKeyValue(*arg);
+                char **next = arg;
 
-            if(mHelp)
-                std::cout << "Use --help or -h to list the command line options." << std::endl;
+                if(keyValue.key)
+                {
+                    const Route *route = findRoute(keyValue);
+
+                    if(route)
+                        next = mParsers[route->parser]->matchNamedOption(route->option, keyValue, arg, end, mParsers[route->parser]->mBindings, *mParsers[route->parser]->mState);
+                }
+                else if(mPositionalOwner != NoRoute)
+                    next = mParsers[mPositionalOwner]->matchPositionals(arg, mParsers[mPositionalOwner]->mBindings, *mParsers[mPositionalOwner]->mState);
+
+                if(next == arg)
+                    throw std::logic_error("No option matches argument '" + std::string(*arg) + "'" + suggestion(*arg));
+
+                arg = next;
+            }
+
+            for(Parser *parser : mParsers)
+                parser->endParse(parser->mBindings, *parser->mState);
+        }
+        catch(std::logic_error &e)
+        {
+            for(Parser *parser : mParsers)
+                parser->cancelActions(*parser->mState);
 
+            write("Error parsing command line arguments: " + std::string(e.what()) + "\n" + (helpEnabled() ? "Use --help or -h to list the command line options.\n" : ""));
             throw e;
         }
     }
 
 private:
-    std::string mCommand;
-    std::string mAppName;
-    std::vector<std::string> mArgs;
-    std::vector<Option> mOptions;
-    bool mHelp = true;
+    struct Route
+    {
+        std::uint32_t parser = NoRoute;
+        std::uint32_t option = NoRoute;
+    };
+
+    enum : std::uint32_t
+    {
+        NoRoute = 0xFFFFFFFF
+    };
+
+    bool helpEnabled() const
+    {
+        return std::any_of(mParsers.cbegin(), mParsers.cend(), [](const Parser *parser) { return parser->mHelp; });
+    }
+
+    const Route *findRoute(const Option::KeyValue &keyValue) const
+    {
+        if(!keyValue.key)
+            return nullptr;
+
+        const Route *route = keyValue.longName ? findRoute(keyValue.key, keyValue.keySize) : (keyValue.keySize == 1 ? &mShortNames[static_cast<unsigned char>(*keyValue.key)] : nullptr);
+        return route && route->parser != NoRoute ? route : nullptr;
+    }
+
+    const Route *findRoute(const char *name, std::size_t size) const
+    {
+        if(mRoutes.empty())
+            return nullptr;
+
+        const std::size_t mask = mRoutes.size() - 1;
+
+        for(std::size_t slot = Parser::hashName(name, size, 0) & mask; mRoutes[slot].parser != NoRoute; slot = (slot + 1) & mask)
+        {
+            const InternedString &longName = routeName(mRoutes[slot]);
+
+            if(longName.size() == size && std::memcmp(longName.data(), name, size) == 0)
+                return &mRoutes[slot];
+        }
+
+        return nullptr;
+    }
+
+    const InternedString &routeName(const Route &route) const
+    {
+        return mParsers[route.parser]->mOptions[route.option].d->longName;
+    }
+
+    void addRoute(const Route &route)
+    {
+        if((mRouteCount + 1) * 2 > mRoutes.size())
+        {
+            std::vector<Route> routes(std::max<std::size_t>(mRoutes.size() * 2, 64));
+            routes.swap(mRoutes);
+
+            for(const Route &existing : routes)
+            {
+                if(existing.parser != NoRoute)
+                    insertRoute(existing);
+            }
+        }
+
+        insertRoute(route);
+        ++mRouteCount;
+    }
+
+    void insertRoute(const Route &route)
+    {
+        const InternedString &name = routeName(route);
+        const std::size_t mask = mRoutes.size() - 1;
+        std::size_t slot = Parser::hashName(name.data(), name.size(), 0) & mask;
+
+        while(mRoutes[slot].parser != NoRoute)
+            slot = (slot + 1) & mask;
+
+        mRoutes[slot] = route;
+    }
+
+    void displayHelp(const char *argument)
+    {
+        const bool search = std::all_of(mParsers.cbegin(), mParsers.cend(), [](const Parser *parser) { return parser->mHelpSearch != nullptr; });
+        const char *term = search ? Parser::helpTerm(argument) : nullptr;
+        std::string options;
+
+        for(Parser *parser : mParsers)
+        {
+            options += parser->formatOptions(parser->helpOptions(term));
+            parser->mState->helpDisplayed = true;
+        }
+
+        write("Usage: " + (mParsers.empty() ? std::string() : mParsers.front()->applicationName()) + " [options]\n" + Parser::helpHeading(term, options.empty()) + options + "\n");
+        mHelpDisplayed = true;
+    }
+
+    std::string suggestion(const char *argument)
+    {
+        for(Parser *parser : mParsers)
+        {
+            std::string suggestion = parser->suggestion(argument);
+
+            if(!suggestion.empty())
+                return suggestion;
+        }
+
+        return std::string();
+    }
+
+    void write(const std::string &text) const
+    {
+        if(mOutput)
+            mOutput(text);
+        else
+        {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            std::fflush(stdout);
+        }
+    }
+
+    std::vector<Parser*> mParsers;
+    std::vector<Route> mRoutes;
+    std::size_t mRouteCount = 0;
+    Route mShortNames[128];
+    std::uint32_t mPositionalOwner = NoRoute;
     bool mHelpDisplayed = false;
+    std::function<void(const std::string &text)> mOutput;
 };
 
 }
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "cppcommandline.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cppcommandline
+{
+
+class BlobDecoder
+{
+public:
+    enum : std::size_t
+    {
+        Invalid = ~std::size_t(0)
+    };
+
+    static std::size_t hexSize(const char *, std::size_t size)
+    {
+        return size % 2 == 0 ? size / 2 : Invalid;
+    }
+
+    static std::size_t base64Size(const char *text, std::size_t size)
+    {
+        if(size % 4 != 0)
+            return Invalid;
+
+        const std::size_t padding = size == 0 || text[size - 1] != '=' ? 0 : (text[size - 2] == '=' ? 2 : 1);
+        return size / 4 * 3 - padding;
+    }
+
+    static bool decodeHex(const char *text, std::size_t size, unsigned char *output)
+    {
+        std::size_t i = 0;
+
+#ifdef CPPCOMMANDLINE_SSE2
+        for(; i + 32 <= size; i += 32, output += 16)
+        {
+            if(!decodeHex32(text + i, output))
+                return false;
+        }
+#endif
+
+        for(; i + 2 <= size; i += 2)
+        {
+            const int high = hexValue(text[i]);
+            const int low = hexValue(text[i + 1]);
+
+            if((high | low) < 0)
+                return false;
+
+            *output++ = static_cast<unsigned char>(high << 4 | low);
+        }
+
+        return i == size;
+    }
+
+    static bool decodeBase64(const char *text, std::size_t size, unsigned char *output)
+    {
+        if(size % 4 != 0)
+            return false;
+
+        std::size_t i = 0;
+
+#ifdef CPPCOMMANDLINE_SSE2
+        for(; i + 20 <= size; i += 16, output += 12)
+        {
+            if(!decodeBase64x16(text + i, output))
+                return false;
+        }
+#endif
+
+        for(; i < size; i += 4)
+        {
+            const bool last = i + 4 == size;
+            const int padding = last && text[i + 3] == '=' ? (text[i + 2] == '=' ? 2 : 1) : 0;
+            const int a = base64Value(text[i]);
+            const int b = base64Value(text[i + 1]);
+            const int c = padding == 2 ? 0 : base64Value(text[i + 2]);
+            const int d = padding != 0 ? 0 : base64Value(text[i + 3]);
+
+            if((a | b | c | d) < 0)
+                return false;
+
+            const unsigned value = static_cast<unsigned>(a << 18 | b << 12 | c << 6 | d);
+            *output++ = static_cast<unsigned char>(value >> 16);
+
+            if(padding < 2)
+                *output++ = static_cast<unsigned char>(value >> 8);
+
+            if(padding < 1)
+                *output++ = static_cast<unsigned char>(value);
+        }
+
+        return true;
+    }
+
+private:
+    static int hexValue(char c)
+    {
+        if(c >= '0' && c <= '9')
+            return c - '0';
+        else if(c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        else
+            return -1;
+    }
+
+    static int base64Value(char c)
+    {
+        if(c >= 'A' && c <= 'Z')
+            return c - 'A';
+        else if(c >= 'a' && c <= 'z')
+            return c - 'a' + 26;
+        else if(c >= '0' && c <= '9')
+            return c - '0' + 52;
+        else if(c == '+')
+            return 62;
+        else if(c == '/')
+            return 63;
+        else
+            return -1;
+    }
+
+#ifdef CPPCOMMANDLINE_SSE2
+    static __m128i inRange(__m128i c, char first, char last)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(static_cast<char>(first - 1))), _mm_cmplt_epi8(c, _mm_set1_epi8(static_cast<char>(last + 1))));
+    }
+
+    static __m128i hexValues(__m128i c, __m128i &valid)
+    {
+        const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+        const __m128i digit = inRange(c, '0', '9');
+        const __m128i letter = inRange(lower, 'a', 'f');
+        valid = _mm_and_si128(valid, _mm_or_si128(digit, letter));
+        return _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))), _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    }
+
+    static bool decodeHex32(const char *text, unsigned char *output)
+    {
+        __m128i valid = _mm_set1_epi8(-1);
+        const __m128i first = hexValues(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text)), valid);
+        const __m128i second = hexValues(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + 16)), valid);
+
+        if(_mm_movemask_epi8(valid) != 0xFFFF)
+            return false;
+
+        const __m128i low = _mm_set1_epi16(0xFF);
+        const __m128i firstBytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, low), 4), _mm_srli_epi16(first, 8));
+        const __m128i secondBytes = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, low), 4), _mm_srli_epi16(second, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_packus_epi16(firstBytes, secondBytes));
+        return true;
+    }
+
+    static bool decodeBase64x16(const char *text, unsigned char *output)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+        const __m128i upper = inRange(c, 'A', 'Z');
+        const __m128i lower = inRange(c, 'a', 'z');
+        const __m128i digit = inRange(c, '0', '9');
+        const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+        const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+
+        if(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash))) != 0xFFFF)
+            return false;
+
+        const __m128i values = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(upper, _mm_sub_epi8(c, _mm_set1_epi8('A'))), _mm_and_si128(lower, _mm_sub_epi8(c, _mm_set1_epi8('a' - 26)))),
+            _mm_or_si128(_mm_and_si128(digit, _mm_add_epi8(c, _mm_set1_epi8(52 - '0'))), _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62)), _mm_and_si128(slash, _mm_set1_epi8(63)))));
+        const __m128i byte = _mm_set1_epi32(0xFF);
+        const __m128i packed = _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(_mm_and_si128(values, byte), 18), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(values, 8), byte), 12)),
+            _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(values, 16), byte), 6), _mm_srli_epi32(values, 24)));
+        std::uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), packed);
+
+        for(std::uint32_t lane : lanes)
+        {
+            *output++ = static_cast<unsigned char>(lane >> 16);
+            *output++ = static_cast<unsigned char>(lane >> 8);
+            *output++ = static_cast<unsigned char>(lane);
+        }
+
+        return true;
+    }
+#endif
+};
+
+class Blob
+{
+public:
+    enum class Encoding
+    {
+        Hex,
+        Base64
+    };
+
+    Blob(void *buffer, std::size_t capacity, Encoding encoding = Encoding::Base64) :
+        mData(static_cast<unsigned char*>(buffer)),
+        mCapacity(capacity),
+        mEncoding(encoding)
+    {
+
+    }
+
+    const unsigned char *data() const
+    {
+        return mData;
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    std::size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    Encoding encoding() const
+    {
+        return mEncoding;
+    }
+
+private:
+    bool assign(const char *text, std::size_t size)
+    {
+        const std::size_t decodedSize = mEncoding == Encoding::Hex ? BlobDecoder::hexSize(text, size) : BlobDecoder::base64Size(text, size);
+
+        if(decodedSize == BlobDecoder::Invalid || decodedSize > mCapacity)
+            return false;
+        else if(!(mEncoding == Encoding::Hex ? BlobDecoder::decodeHex(text, size, mData) : BlobDecoder::decodeBase64(text, size, mData)))
+            return false;
+
+        mSize = decodedSize;
+        return true;
+    }
+
+    unsigned char *mData;
+    std::size_t mCapacity;
+    std::size_t mSize = 0;
+    Encoding mEncoding;
+
+    friend class Option;
+};
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "cppcommandline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace cppcommandline
+{
+
+class HelpIndex : public Parser::HelpSearch
+{
+public:
+    static void enable(Parser &parser)
+    {
+        parser.mHelpSearch.reset(new HelpIndex);
+        parser.mHelpIndexed = false;
+    }
+
+private:
+    struct Token
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t option = 0;
+    };
+
+    void build(const std::vector<Option> &options) override
+    {
+        mTable.clear();
+        mTokens.clear();
+        mGroups.clear();
+
+        for(std::uint32_t i = 0; i < options.size(); i++)
+        {
+            const Option::OptionPrivate &option = *options[i].d;
+
+            for(const InternedString *text : {&option.longName, &option.shortName, &option.description, &option.group})
+            {
+                for(const std::string &word : words(text->data(), text->size()))
+                    mTokens.push_back(addToken(word.data(), word.size(), i));
+            }
+
+            if(!option.group.empty())
+                mGroups.push_back(addToken(option.group.data(), option.group.size(), i));
+        }
+
+        auto less = [&](const Token &left, const Token &right)
+        {
+            const int result = compare(left, mTable.data() + right.offset, right.size);
+            return result != 0 ? result < 0 : left.option < right.option;
+        };
+
+        std::sort(mTokens.begin(), mTokens.end(), less);
+        std::sort(mGroups.begin(), mGroups.end(), less);
+    }
+
+    std::vector<std::uint32_t> find(const char *term) const override
+    {
+        std::vector<std::uint32_t> options;
+        const std::size_t termSize = std::strlen(term);
+
+        for(auto it = std::lower_bound(mGroups.cbegin(), mGroups.cend(), termSize, [&](const Token &token, std::size_t) { return compare(token, term, termSize) < 0; }); it != mGroups.cend() && compare(*it, term, termSize) == 0; ++it)
+            options.push_back(it->option);
+
+        if(!options.empty())
+            return options;
+
+        std::vector<std::string> termWords = words(term, termSize);
+
+        for(std::size_t i = 0; i < termWords.size(); i++)
+        {
+            const std::string &word = termWords[i];
+            std::vector<std::uint32_t> matches;
+            auto isPrefix = [&](const Token &token) { return token.size >= word.size() && std::memcmp(mTable.data() + token.offset, word.data(), word.size()) == 0; };
+            auto first = std::lower_bound(mTokens.cbegin(), mTokens.cend(), word, [&](const Token &token, const std::string &) { return compare(token, word.data(), word.size()) < 0; });
+
+            for(auto it = first; it != mTokens.cend() && isPrefix(*it); ++it)
+                matches.push_back(it->option);
+
+            std::sort(matches.begin(), matches.end());
+            matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+            if(i == 0)
+                options.swap(matches);
+            else
+            {
+                std::vector<std::uint32_t> both;
+                std::set_intersection(options.cbegin(), options.cend(), matches.cbegin(), matches.cend(), std::back_inserter(both));
+                options.swap(both);
+            }
+        }
+
+        return options;
+    }
+
+    Token addToken(const char *text, std::size_t size, std::uint32_t option)
+    {
+        Token token;
+        token.offset = static_cast<std::uint32_t>(mTable.size());
+        token.size = static_cast<std::uint32_t>(size);
+        token.option = option;
+        mTable.append(text, size);
+        return token;
+    }
+
+    int compare(const Token &token, const char *text, std::size_t size) const
+    {
+        const int result = std::memcmp(mTable.data() + token.offset, text, std::min<std::size_t>(token.size, size));
+        return result != 0 ? result : (token.size < size ? -1 : (token.size > size ? 1 : 0));
+    }
+
+    static std::vector<std::string> words(const char *text, std::size_t size)
+    {
+        std::vector<std::string> words;
+        std::string word;
+
+        for(std::size_t i = 0; i <= size; i++)
+        {
+            if(i < size && (Option::isAlphaNumeric(text[i])))
+                word += static_cast<char>(text[i] >= 'A' && text[i] <= 'Z' ? text[i] - 'A' + 'a' : text[i]);
+            else if(!word.empty())
+            {
+                words.push_back(word);
+                word.clear();
+            }
+        }
+
+        return words;
+    }
+
+    std::string mTable;
+    std::vector<Token> mTokens;
+    std::vector<Token> mGroups;
+};
+
+}
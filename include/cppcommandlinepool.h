@@ -0,0 +1,173 @@
+#pragma once
+
+#include "cppcommandline.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cppcommandline
+{
+
+class StringPool
+{
+public:
+    static StringPool &instance()
+    {
+        static StringPool *pool = new StringPool;
+        return *pool;
+    }
+
+    InternedString intern(const std::string &text)
+    {
+        return intern(text.data(), text.size(), true);
+    }
+
+    InternedString intern(StringLiteral text)
+    {
+        return intern(text.data(), text.size(), false);
+    }
+
+    std::size_t count() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.size();
+    }
+
+    std::size_t copiedBytes() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mCopiedBytes;
+    }
+
+    static void enable()
+    {
+        InternedString::interner().store(&StringPool::internShared, std::memory_order_release);
+    }
+
+private:
+    struct Entry
+    {
+        const char *data;
+        std::size_t size;
+        std::uint64_t hash;
+    };
+
+    enum : std::size_t
+    {
+        BlockSize = 16384
+    };
+
+    StringPool() :
+        mSlots(64, 0)
+    {
+        mEntries.push_back(Entry{"", 0, hashOf("", 0)});
+    }
+
+    static InternedString internShared(const char *text, std::size_t size, bool copy)
+    {
+        return instance().intern(text, size, copy);
+    }
+
+    InternedString intern(const char *text, std::size_t size, bool copy)
+    {
+        if(size == 0)
+            return InternedString();
+
+        const std::uint64_t hash = hashOf(text, size);
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::size_t slot = findSlot(text, size, hash);
+
+        if(mSlots[slot] == 0)
+        {
+            mEntries.push_back(Entry{copy ? store(text, size) : text, size, hash});
+            mSlots[slot] = static_cast<std::uint32_t>(mEntries.size() - 1);
+
+            if(mEntries.size() * 2 > mSlots.size())
+                rehash();
+        }
+
+        const Entry &entry = mEntries[mSlots[findSlot(text, size, hash)]];
+        return InternedString(static_cast<std::uint32_t>(&entry - mEntries.data()), entry.data, entry.size);
+    }
+
+    std::size_t findSlot(const char *text, std::size_t size, std::uint64_t hash) const
+    {
+        const std::size_t mask = mSlots.size() - 1;
+        std::size_t slot = static_cast<std::size_t>(hash) & mask;
+
+        for(; mSlots[slot] != 0; slot = (slot + 1) & mask)
+        {
+            const Entry &entry = mEntries[mSlots[slot]];
+
+            if(entry.hash == hash && entry.size == size && std::memcmp(entry.data, text, size) == 0)
+                break;
+        }
+
+        return slot;
+    }
+
+    void rehash()
+    {
+        mSlots.assign(mSlots.size() * 2, 0);
+
+        for(std::uint32_t id = 1; id < mEntries.size(); id++)
+            mSlots[findSlot(mEntries[id].data, mEntries[id].size, mEntries[id].hash)] = id;
+    }
+
+    const char *store(const char *text, std::size_t size)
+    {
+        char *data = nullptr;
+
+        if(size + 1 > BlockSize / 4)
+        {
+            mBlocks.emplace_back(new char[size + 1]);
+            data = mBlocks.back().get();
+        }
+        else
+        {
+            if(mFreeSize < size + 1)
+            {
+                mBlocks.emplace_back(new char[BlockSize]);
+                mFree = mBlocks.back().get();
+                mFreeSize = BlockSize;
+            }
+
+            data = mFree;
+            mFree += size + 1;
+            mFreeSize -= size + 1;
+        }
+
+        std::memcpy(data, text, size);
+        data[size] = '\0';
+        mCopiedBytes += size + 1;
+        return data;
+    }
+
+    static std::uint64_t hashOf(const char *text, std::size_t size)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+
+        for(std::size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(text[i]);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    mutable std::mutex mMutex;
+    std::vector<Entry> mEntries;
+    std::vector<std::uint32_t> mSlots;
+    std::vector<std::unique_ptr<char[]>> mBlocks;
+    char *mFree = nullptr;
+    std::size_t mFreeSize = 0;
+    std::size_t mCopiedBytes = 0;
+};
+
+}
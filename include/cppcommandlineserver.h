@@ -0,0 +1,644 @@
+#pragma once
+
+#include "cppcommandline.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace cppcommandline
+{
+
+class ParseResult
+{
+public:
+    enum class Status : std::uint8_t
+    {
+        Parsed,
+        Help,
+        Error
+    };
+
+    Status status() const
+    {
+        return mStatus;
+    }
+
+    const std::string &message() const
+    {
+        return mMessage;
+    }
+
+    std::size_t count() const
+    {
+        return mValues.size();
+    }
+
+    std::size_t indexOf(const std::string &longName) const
+    {
+        for(std::size_t i = 0; i < mValues.size(); i++)
+        {
+            if(!longName.empty() && mValues[i].name == longName)
+                return i;
+        }
+
+        throw std::logic_error("There is no option '" + longName + "'.");
+    }
+
+    const std::string &longName(std::size_t index) const
+    {
+        return mValues.at(index).name;
+    }
+
+    bool isMatched(std::size_t index) const
+    {
+        return mValues.at(index).matched;
+    }
+
+    bool isMatched(const std::string &longName) const
+    {
+        return isMatched(indexOf(longName));
+    }
+
+    template<typename T>
+    const T &value(std::size_t index) const
+    {
+        const Value &value = mValues.at(index);
+
+        if(value.type != type<T>())
+            throw std::logic_error("The option '" + value.name + "' does not have the requested type.");
+
+        return get<T>(value);
+    }
+
+    template<typename T>
+    const T &value(const std::string &longName) const
+    {
+        return value<T>(indexOf(longName));
+    }
+
+private:
+    enum class Type : std::uint8_t
+    {
+        Undefined,
+        String,
+        Integer,
+        LongLong,
+        Double,
+        Bool,
+        IntegerList,
+        LongLongList,
+        DoubleList
+    };
+
+    struct Value
+    {
+        std::string name;
+        Type type = Type::Undefined;
+        bool matched = false;
+        int integer = 0;
+        long long longLong = 0;
+        double number = 0.0;
+        bool flag = false;
+        std::string string;
+        std::vector<int> integers;
+        std::vector<long long> longLongs;
+        std::vector<double> doubles;
+    };
+
+    template<typename T> static Type type();
+    template<typename T> static const T &get(const Value &value);
+
+    Status mStatus = Status::Error;
+    std::string mMessage;
+    std::vector<Value> mValues;
+
+    friend class ParseServer;
+    friend class ParseClient;
+};
+
+template<> inline ParseResult::Type ParseResult::type<std::string>() { return Type::String; }
+template<> inline ParseResult::Type ParseResult::type<int>() { return Type::Integer; }
+template<> inline ParseResult::Type ParseResult::type<long long>() { return Type::LongLong; }
+template<> inline ParseResult::Type ParseResult::type<double>() { return Type::Double; }
+template<> inline ParseResult::Type ParseResult::type<bool>() { return Type::Bool; }
+template<> inline ParseResult::Type ParseResult::type<std::vector<int>>() { return Type::IntegerList; }
+template<> inline ParseResult::Type ParseResult::type<std::vector<long long>>() { return Type::LongLongList; }
+template<> inline ParseResult::Type ParseResult::type<std::vector<double>>() { return Type::DoubleList; }
+template<> inline const std::string &ParseResult::get(const Value &value) { return value.string; }
+template<> inline const int &ParseResult::get(const Value &value) { return value.integer; }
+template<> inline const long long &ParseResult::get(const Value &value) { return value.longLong; }
+template<> inline const double &ParseResult::get(const Value &value) { return value.number; }
+template<> inline const bool &ParseResult::get(const Value &value) { return value.flag; }
+template<> inline const std::vector<int> &ParseResult::get(const Value &value) { return value.integers; }
+template<> inline const std::vector<long long> &ParseResult::get(const Value &value) { return value.longLongs; }
+template<> inline const std::vector<double> &ParseResult::get(const Value &value) { return value.doubles; }
+
+class ParseSocket
+{
+public:
+    enum : std::uint32_t
+    {
+        MaxMessageSize = 16 * 1024 * 1024
+    };
+
+    explicit ParseSocket(int socket) :
+        mSocket(socket)
+    {
+
+    }
+
+    ParseSocket(const ParseSocket &other) = delete;
+    ParseSocket &operator=(const ParseSocket &other) = delete;
+
+    ~ParseSocket()
+    {
+        if(mSocket >= 0)
+            ::close(mSocket);
+    }
+
+    int handle() const
+    {
+        return mSocket;
+    }
+
+    static sockaddr_un address(const std::string &path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if(path.empty() || path.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("The socket path '" + path + "' is empty or too long.");
+
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return address;
+    }
+
+    void send(const std::string &message)
+    {
+        const std::uint32_t size = static_cast<std::uint32_t>(message.size());
+        sendAll(reinterpret_cast<const char*>(&size), sizeof(size));
+        sendAll(message.data(), message.size());
+    }
+
+    bool receive(std::string &message)
+    {
+        std::uint32_t size = 0;
+
+        if(!receiveAll(reinterpret_cast<char*>(&size), sizeof(size)))
+            return false;
+        else if(size > MaxMessageSize)
+            throw std::runtime_error("The parse message is too large.");
+
+        message.resize(size);
+        return size == 0 || receiveAll(&message[0], size);
+    }
+
+private:
+    void sendAll(const char *data, std::size_t size)
+    {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+
+        while(size != 0)
+        {
+            const ssize_t sent = ::send(mSocket, data, size, flags);
+
+            if(sent < 0 && errno == EINTR)
+                continue;
+            else if(sent <= 0)
+                throw std::runtime_error("Cannot write to the parse socket: " + std::string(std::strerror(errno)));
+
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+    }
+
+    bool receiveAll(char *data, std::size_t size)
+    {
+        while(size != 0)
+        {
+            const ssize_t received = ::recv(mSocket, data, size, 0);
+
+            if(received < 0 && errno == EINTR)
+                continue;
+            else if(received < 0)
+                throw std::runtime_error("Cannot read from the parse socket: " + std::string(std::strerror(errno)));
+            else if(received == 0)
+                return false;
+
+            data += received;
+            size -= static_cast<std::size_t>(received);
+        }
+
+        return true;
+    }
+
+    int mSocket;
+};
+
+class ParseServer
+{
+public:
+    ParseServer(Parser &parser, std::string path, std::size_t workers = 4, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) :
+        mParser(parser),
+        mPath(std::move(path)),
+        mSocket(::socket(AF_UNIX, SOCK_STREAM, 0)),
+        mWorkers(workers == 0 ? 1 : workers),
+        mTimeout(timeout)
+    {
+        if(mSocket.handle() < 0)
+            throw std::runtime_error("Cannot create the parse socket: " + std::string(std::strerror(errno)));
+
+        const sockaddr_un address = ParseSocket::address(mPath);
+        struct stat status;
+
+        if(::lstat(mPath.c_str(), &status) == 0)
+        {
+            if(!S_ISSOCK(status.st_mode))
+                throw std::runtime_error("Cannot listen on '" + mPath + "': the file exists and is not a socket.");
+
+            ::unlink(mPath.c_str());
+        }
+
+        if(::bind(mSocket.handle(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(mSocket.handle(), SOMAXCONN) != 0)
+            throw std::runtime_error("Cannot listen on '" + mPath + "': " + std::string(std::strerror(errno)));
+
+        mParser.freeze();
+        mParser.buildHelpIndex();
+        mParser.buildSuggestionIndex();
+    }
+
+    ParseServer(const ParseServer &other) = delete;
+    ParseServer &operator=(const ParseServer &other) = delete;
+
+    ~ParseServer()
+    {
+        ::unlink(mPath.c_str());
+    }
+
+    void serve()
+    {
+        std::vector<std::thread> workers;
+
+        for(std::size_t i = 0; i < mWorkers; i++)
+            workers.emplace_back([this]() { work(); });
+
+        try
+        {
+            accept();
+        }
+        catch(...)
+        {
+            finish(workers);
+            throw;
+        }
+
+        finish(workers);
+    }
+
+    void stop()
+    {
+        mStopped.store(true, std::memory_order_release);
+        ::shutdown(mSocket.handle(), SHUT_RDWR);
+    }
+
+private:
+    void accept()
+    {
+        while(!mStopped.load(std::memory_order_acquire))
+        {
+            const int client = ::accept(mSocket.handle(), nullptr, nullptr);
+
+            if(client < 0)
+            {
+                if(errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                else if(mStopped.load(std::memory_order_acquire))
+                    return;
+                else
+                    throw std::runtime_error("Cannot accept on '" + mPath + "': " + std::string(std::strerror(errno)));
+            }
+
+            timeval timeout;
+            timeout.tv_sec = static_cast<time_t>(mTimeout.count() / 1000);
+            timeout.tv_usec = static_cast<suseconds_t>(mTimeout.count() % 1000 * 1000);
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mClients.push_back(client);
+            }
+
+            mWake.notify_one();
+        }
+    }
+
+    void finish(std::vector<std::thread> &workers)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFinished = true;
+        }
+
+        mWake.notify_all();
+
+        for(std::thread &worker : workers)
+            worker.join();
+
+        for(int client : mClients)
+            ::close(client);
+
+        mClients.clear();
+        mFinished = false;
+    }
+
+    void work()
+    {
+        Parser::ParseState state;
+        std::string output;
+        mParser.prepareState(state);
+        state.output = &output;
+
+        for(;;)
+        {
+            int client = -1;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait(lock, [this]() { return mFinished || !mClients.empty(); });
+
+                if(mFinished)
+                    return;
+
+                client = mClients.front();
+                mClients.pop_front();
+            }
+
+            serve(client, state);
+        }
+    }
+
+    void serve(int client, Parser::ParseState &state)
+    {
+        ParseSocket socket(client);
+        std::string request;
+        std::string response;
+
+        try
+        {
+            if(!socket.receive(request))
+                return;
+
+            response = respond(request, state);
+            socket.send(response);
+        }
+        catch(std::runtime_error &)
+        {
+        }
+    }
+
+    std::string respond(std::string &request, Parser::ParseState &state)
+    {
+        std::vector<char*> arguments;
+
+        for(std::size_t offset = 0; offset < request.size(); offset += std::strlen(&request[offset]) + 1)
+            arguments.push_back(&request[offset]);
+
+        arguments.push_back(nullptr);
+        std::string &output = *state.output;
+        output.clear();
+        ParseResult::Status status = ParseResult::Status::Parsed;
+        std::unique_ptr<Settings> settings;
+
+        if(request.empty() || request.back() != '\0')
+        {
+            status = ParseResult::Status::Error;
+            output = "Malformed parse request.";
+        }
+        else
+        {
+            try
+            {
+                settings = mParser.parseSettings(static_cast<int>(arguments.size()) - 1, arguments.data(), state);
+
+                if(state.helpDisplayed)
+                    status = ParseResult::Status::Help;
+            }
+            catch(std::logic_error &e)
+            {
+                status = ParseResult::Status::Error;
+                output = e.what();
+            }
+        }
+
+        std::string response(1, static_cast<char>(status));
+        appendString(response, output);
+
+        if(status == ParseResult::Status::Parsed)
+        {
+            appendNumber(response, static_cast<std::uint32_t>(mParser.mOptions.size()));
+
+            for(std::size_t i = 0; i < mParser.mOptions.size(); i++)
+                appendValue(response, mParser.mOptions[i], settings->mValues[i], settings->mMatched[i]);
+        }
+
+        return response;
+    }
+
+    static void appendValue(std::string &response, const Option &option, const Settings::Value &value, bool matched)
+    {
+        appendString(response, option.d->longName.str());
+
+        switch(option.d->type)
+        {
+        case Option::Type::String: appendHeader(response, ParseResult::Type::String, matched); appendString(response, value.string); break;
+        case Option::Type::Integer: appendHeader(response, ParseResult::Type::Integer, matched); appendNumber(response, value.number.i); break;
+        case Option::Type::LongLong: appendHeader(response, ParseResult::Type::LongLong, matched); appendNumber(response, value.number.l); break;
+        case Option::Type::Double: appendHeader(response, ParseResult::Type::Double, matched); appendNumber(response, value.number.d); break;
+        case Option::Type::Bool: appendHeader(response, ParseResult::Type::Bool, matched); response.push_back(value.number.b ? 1 : 0); break;
+        case Option::Type::IntegerList: appendHeader(response, ParseResult::Type::IntegerList, matched); appendList(response, value.integers); break;
+        case Option::Type::LongLongList: appendHeader(response, ParseResult::Type::LongLongList, matched); appendList(response, value.longLongs); break;
+        case Option::Type::DoubleList: appendHeader(response, ParseResult::Type::DoubleList, matched); appendList(response, value.doubles); break;
+        case Option::Type::Tuple:
+        case Option::Type::Blob:
+        case Option::Type::View:
+        case Option::Type::Lazy:
+        case Option::Type::Undefined: appendHeader(response, ParseResult::Type::Undefined, matched); break;
+        }
+    }
+
+    static void appendHeader(std::string &response, ParseResult::Type type, bool matched)
+    {
+        response.push_back(static_cast<char>(type));
+        response.push_back(matched ? 1 : 0);
+    }
+
+    template<typename T>
+    static void appendNumber(std::string &response, T number)
+    {
+        response.append(reinterpret_cast<const char*>(&number), sizeof(number));
+    }
+
+    static void appendString(std::string &response, const std::string &text)
+    {
+        appendNumber(response, static_cast<std::uint32_t>(text.size()));
+        response += text;
+    }
+
+    template<typename T>
+    static void appendList(std::string &response, const std::vector<T> &list)
+    {
+        appendNumber(response, static_cast<std::uint32_t>(list.size()));
+        response.append(reinterpret_cast<const char*>(list.data()), list.size() * sizeof(T));
+    }
+
+    Parser &mParser;
+    std::string mPath;
+    ParseSocket mSocket;
+    std::size_t mWorkers;
+    std::chrono::milliseconds mTimeout;
+    std::atomic<bool> mStopped{false};
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<int> mClients;
+    bool mFinished = false;
+};
+
+class ParseClient
+{
+public:
+    explicit ParseClient(std::string path) :
+        mPath(std::move(path))
+    {
+
+    }
+
+    ParseResult parse(int argc, char **argv) const
+    {
+        ParseSocket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        const sockaddr_un address = ParseSocket::address(mPath);
+
+        if(socket.handle() < 0 || ::connect(socket.handle(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+            throw std::runtime_error("Cannot connect to the parse server at '" + mPath + "': " + std::string(std::strerror(errno)));
+
+        std::string request;
+
+        for(int i = 0; i < argc; i++)
+            request.append(argv[i], std::strlen(argv[i]) + 1);
+
+        std::string response;
+        socket.send(request);
+
+        if(!socket.receive(response))
+            throw std::runtime_error("The parse server at '" + mPath + "' closed the connection.");
+
+        return decode(response);
+    }
+
+private:
+    class Decoder
+    {
+    public:
+        explicit Decoder(const std::string &data) :
+            mData(data)
+        {
+
+        }
+
+        template<typename T>
+        T number()
+        {
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string string()
+        {
+            const std::uint32_t size = number<std::uint32_t>();
+            return std::string(take(size), size);
+        }
+
+        template<typename T>
+        void list(std::vector<T> &values)
+        {
+            values.resize(number<std::uint32_t>());
+
+            if(!values.empty())
+                std::memcpy(values.data(), take(values.size() * sizeof(T)), values.size() * sizeof(T));
+        }
+
+    private:
+        const char *take(std::size_t size)
+        {
+            if(mData.size() - mOffset < size)
+                throw std::runtime_error("The parse response is truncated.");
+
+            const char *data = mData.data() + mOffset;
+            mOffset += size;
+            return data;
+        }
+
+        const std::string &mData;
+        std::size_t mOffset = 0;
+    };
+
+    static ParseResult decode(const std::string &response)
+    {
+        Decoder decoder(response);
+        ParseResult result;
+        result.mStatus = static_cast<ParseResult::Status>(decoder.number<std::uint8_t>());
+        result.mMessage = decoder.string();
+
+        if(result.mStatus != ParseResult::Status::Parsed)
+            return result;
+
+        result.mValues.resize(decoder.number<std::uint32_t>());
+
+        for(ParseResult::Value &value : result.mValues)
+        {
+            value.name = decoder.string();
+            value.type = static_cast<ParseResult::Type>(decoder.number<std::uint8_t>());
+            value.matched = decoder.number<std::uint8_t>() != 0;
+
+            switch(value.type)
+            {
+            case ParseResult::Type::String: value.string = decoder.string(); break;
+            case ParseResult::Type::Integer: value.integer = decoder.number<int>(); break;
+            case ParseResult::Type::LongLong: value.longLong = decoder.number<long long>(); break;
+            case ParseResult::Type::Double: value.number = decoder.number<double>(); break;
+            case ParseResult::Type::Bool: value.flag = decoder.number<std::uint8_t>() != 0; break;
+            case ParseResult::Type::IntegerList: decoder.list(value.integers); break;
+            case ParseResult::Type::LongLongList: decoder.list(value.longLongs); break;
+            case ParseResult::Type::DoubleList: decoder.list(value.doubles); break;
+            case ParseResult::Type::Undefined: break;
+            }
+        }
+
+        return result;
+    }
+
+    std::string mPath;
+};
+
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "cppcommandline.h"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cppcommandline
+{
+
+class TraceRecord
+{
+public:
+    enum class Kind : std::uint8_t
+    {
+        Arguments = 'A',
+        Environment = 'E',
+        Configuration = 'C'
+    };
+
+    TraceRecord() = default;
+
+    TraceRecord(const TraceRecord &other) :
+        mKind(other.mKind),
+        mData(other.mData)
+    {
+        rebase(other);
+    }
+
+    TraceRecord(TraceRecord &&other) = default;
+
+    TraceRecord &operator=(const TraceRecord &other)
+    {
+        if(this != &other)
+        {
+            mKind = other.mKind;
+            mData = other.mData;
+            rebase(other);
+        }
+
+        return *this;
+    }
+
+    TraceRecord &operator=(TraceRecord &&other) = default;
+
+    Kind kind() const
+    {
+        return mKind;
+    }
+
+    int count() const
+    {
+        return static_cast<int>(mArguments.size()) - 1;
+    }
+
+    char **arguments()
+    {
+        return mArguments.data();
+    }
+
+private:
+    void rebase(const TraceRecord &other)
+    {
+        mArguments.clear();
+
+        for(char *argument : other.mArguments)
+            mArguments.push_back(argument ? mData.data() + (argument - other.mData.data()) : nullptr);
+    }
+
+    Kind mKind = Kind::Arguments;
+    std::vector<char> mData;
+    std::vector<char*> mArguments{nullptr};
+
+    friend class TraceReader;
+};
+
+class TraceRecorder
+{
+public:
+    explicit TraceRecorder(const std::string &fileName, unsigned sampleEvery = 1, std::size_t bufferSize = 65536) :
+        mFile(std::fopen(fileName.c_str(), "wb")),
+        mSampleEvery(sampleEvery == 0 ? 1 : sampleEvery),
+        mBufferSize(bufferSize)
+    {
+        if(!mFile)
+            throw std::runtime_error("Cannot open the trace file '" + fileName + "'.");
+
+        mBuffer.reserve(bufferSize + 4096);
+        mBuffer.append("CLT1", 4);
+    }
+
+    TraceRecorder(const TraceRecorder &other) = delete;
+    TraceRecorder &operator=(const TraceRecorder &other) = delete;
+
+    ~TraceRecorder()
+    {
+        try
+        {
+            flush();
+        }
+        catch(std::runtime_error &)
+        {
+        }
+
+        std::fclose(mFile);
+    }
+
+    void parse(Parser &parser, int argc, char **argv)
+    {
+        record(argc, argv);
+        parser.parse(argc, argv);
+    }
+
+    void record(int argc, char **argv)
+    {
+        append(TraceRecord::Kind::Arguments, argv, argv + argc);
+    }
+
+    void recordEnvironment(char **environment)
+    {
+        char **end = environment;
+
+        while(*end)
+            ++end;
+
+        append(TraceRecord::Kind::Environment, environment, end);
+    }
+
+    void recordConfiguration(const char *data, std::size_t size)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        appendHeader(TraceRecord::Kind::Configuration, 1, size + 1);
+        mBuffer.append(data, size);
+        mBuffer.push_back('\0');
+        flushIfFull();
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        write();
+    }
+
+private:
+    template<typename Iterator>
+    void append(TraceRecord::Kind kind, Iterator begin, Iterator end)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if(kind == TraceRecord::Kind::Arguments && mCalls++ % mSampleEvery != 0)
+            return;
+
+        std::size_t size = 0;
+
+        for(Iterator it = begin; it != end; ++it)
+            size += std::strlen(*it) + 1;
+
+        appendHeader(kind, static_cast<std::uint32_t>(end - begin), size);
+
+        for(Iterator it = begin; it != end; ++it)
+            mBuffer.append(*it, std::strlen(*it) + 1);
+
+        flushIfFull();
+    }
+
+    void appendHeader(TraceRecord::Kind kind, std::uint32_t count, std::size_t size)
+    {
+        const std::uint32_t payload = static_cast<std::uint32_t>(size);
+        mBuffer.push_back(static_cast<char>(kind));
+        mBuffer.append(reinterpret_cast<const char*>(&count), sizeof(count));
+        mBuffer.append(reinterpret_cast<const char*>(&payload), sizeof(payload));
+    }
+
+    void flushIfFull()
+    {
+        if(mBuffer.size() >= mBufferSize)
+            write();
+    }
+
+    void write()
+    {
+        if((!mBuffer.empty() && std::fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size()) || std::fflush(mFile) != 0)
+            throw std::runtime_error("Cannot write the trace file.");
+
+        mBuffer.clear();
+    }
+
+    std::FILE *mFile;
+    unsigned mSampleEvery;
+    std::size_t mBufferSize;
+    std::size_t mCalls = 0;
+    std::string mBuffer;
+    std::mutex mMutex;
+};
+
+class TraceReader
+{
+public:
+    explicit TraceReader(const std::string &fileName)
+    {
+        std::FILE *file = std::fopen(fileName.c_str(), "rb");
+
+        if(!file)
+            throw std::runtime_error("Cannot open the trace file '" + fileName + "'.");
+
+        char buffer[65536];
+
+        for(std::size_t read; (read = std::fread(buffer, 1, sizeof(buffer), file)) != 0;)
+            mData.append(buffer, read);
+
+        std::fclose(file);
+
+        if(mData.compare(0, 4, "CLT1") != 0)
+            throw std::runtime_error("The file '" + fileName + "' is not a trace file.");
+
+        mOffset = 4;
+    }
+
+    bool next(TraceRecord &record)
+    {
+        const std::size_t headerSize = 1 + 2 * sizeof(std::uint32_t);
+
+        if(mData.size() - mOffset < headerSize)
+            return false;
+
+        std::uint32_t count = 0;
+        std::uint32_t size = 0;
+        record.mKind = static_cast<TraceRecord::Kind>(mData[mOffset]);
+        std::memcpy(&count, mData.data() + mOffset + 1, sizeof(count));
+        std::memcpy(&size, mData.data() + mOffset + 1 + sizeof(count), sizeof(size));
+
+        if(mData.size() - mOffset - headerSize < size)
+            throw std::runtime_error("The trace file is truncated.");
+        else if(size != 0 && mData[mOffset + headerSize + size - 1] != '\0')
+            throw std::runtime_error("The trace file is corrupted.");
+
+        const char *payload = mData.data() + mOffset + headerSize;
+        record.mData.assign(payload, payload + size);
+        record.mArguments.clear();
+
+        for(std::size_t offset = 0; record.mArguments.size() < count && offset < size; offset += std::strlen(record.mData.data() + offset) + 1)
+            record.mArguments.push_back(record.mData.data() + offset);
+
+        if(record.mArguments.size() != count)
+            throw std::runtime_error("The trace file is corrupted.");
+
+        record.mArguments.push_back(nullptr);
+        mOffset += headerSize + size;
+        return true;
+    }
+
+private:
+    std::string mData;
+    std::size_t mOffset = 0;
+};
+
+}
@@ -1,7 +1,35 @@
 #include "cppcommandlinetest.h"
 #include "qtestbdd.h"
+#include "allocationcounter.h"
+#include "secondunit.h"
 #include "cppcommandline.h"
+#include "cppcommandlineblob.h"
+#include "cppcommandlinehelp.h"
+#include "cppcommandlinepool.h"
+#include "cppcommandlinetrace.h"
 
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include "cppcommandlineserver.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+template<typename T, typename = void>
+struct HasRange : std::false_type
+{
+};
+
+template<typename T>
+struct HasRange<T, decltype(void(std::declval<cppcommandline::Option&>().withRange(std::declval<T>(), std::declval<T>())))> : std::true_type
+{
+};
+}
 
 void CppCommandLineTest::OptionDefaultCtor()
 {
@@ -399,17 +427,1628 @@ void CppCommandLineTest::parseFailed()
     }
 }
 
-void CppCommandLineTest::help()
+void CppCommandLineTest::parseAllocations()
 {
+    {
+    SCENARIO("Parsing numeric and bool options does not allocate")
+    std::vector<const char*> args{"./app", "--count", "10", "-r=2.5", "--flag", "-999999999999"};
+    cppcommandline::Parser parser;
+    int count = 0;
+    double ratio = 0.0;
+    bool flag = false;
+    qint64 positional = 0;
+    parser.option("count").bindTo(count);
+    parser.option("ratio").asShortName("r").bindTo(ratio);
+    parser.option("flag").bindTo(flag);
+    parser.option().bindTo(positional);
+    std::size_t before = allocationCount();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(allocationCount(), before);
+    QCOMPARE(count, 10);
+    QCOMPARE(ratio, 2.5);
+    QCOMPARE(flag, true);
+    QCOMPARE(positional, qint64(-999999999999));
+    }
 
     {
-    SCENARIO("Unmatched required option")
-    std::vector<const char*> args{"./app", "-h"};
+    SCENARIO("Repeated parsing of numeric and bool options does not allocate")
+    std::vector<const char*> args{"/usr/local/bin/some-long-application-name", "-c", "5"};
     cppcommandline::Parser parser;
+    int count = 0;
+    parser.option("count").asShortName("c").bindTo(count);
     parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
-    QVERIFY(parser.helpDisplayed());
+    std::size_t before = allocationCount();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(allocationCount(), before);
+    QCOMPARE(count, 5);
+    QCOMPARE(parser.applicationName(), std::string("some-long-application-name"));
+    }
+}
+
+void CppCommandLineTest::scan()
+{
+    {
+    SCENARIO("Scanner splits a NUL separated blob")
+    const char data[] = "./app\0--option=value\0-v\0-10\0positional argument longer than one vector block\0";
+    std::string blob(data, sizeof(data) - 1);
+    std::vector<cppcommandline::ArgumentScanner::Token> tokens;
+    cppcommandline::ArgumentScanner().scan(&blob[0], blob.size(), tokens);
+    QCOMPARE(tokens.size(), std::size_t(5));
+    QCOMPARE(std::string(tokens[1].data), std::string("--option=value"));
+    QCOMPARE(std::string(tokens[3].data), std::string("-10"));
+    QCOMPARE(tokens[4].size, std::size_t(48));
+    }
+
+    {
+    SCENARIO("Scanner keeps the unterminated last token")
+    std::string blob("a\nb=c");
+    std::vector<cppcommandline::ArgumentScanner::Token> tokens;
+    cppcommandline::ArgumentScanner('\n').scan(&blob[0], blob.size(), tokens);
+    QCOMPARE(tokens.size(), std::size_t(2));
+    QCOMPARE(tokens[1].size, std::size_t(3));
+    }
+
+    {
+    SCENARIO("Parser parses a newline separated blob")
+    std::string blob;
+
+    for(int i = 0; i < 100; i++)
+        blob += "./app\n--value\n--option=file\n-y\n10\n";
+
+    blob.erase(blob.find("./app", 1));
+    cppcommandline::Parser parser;
+    bool value = false;
+    std::string option;
+    int another = 0;
+    parser.option("value").bindTo(value);
+    parser.option("option").bindTo(option);
+    parser.option("yetanother").asShortName("y").bindTo(another);
+    parser.parse(&blob[0], blob.size(), '\n');
+    QCOMPARE(value, true);
+    QCOMPARE(option, std::string("file"));
+    QCOMPARE(another, 10);
+    QCOMPARE(parser.command(), std::string("./app"));
+    }
+
+    {
+    SCENARIO("Unterminated blob")
+    std::string blob("./app\n-v");
+    QVERIFY_EXCEPTION_THROWN(cppcommandline::Parser().parse(&blob[0], blob.size(), '\n'), std::logic_error);
+    }
+}
+
+void CppCommandLineTest::freeze()
+{
+    {
+    SCENARIO("Frozen parser matches mixed options")
+    std::vector<const char*> args{"./app", "-v", "-o=file", "--yetanother", "10", "somefile", "-5"};
+    cppcommandline::Parser parser;
+    bool value;
+    std::string option;
+    int another = 0;
+    std::string positional;
+    int number = 0;
+    parser.option("value").asShortName("v").bindTo(value);
+    parser.option("option").asShortName("o").bindTo(option);
+    parser.option("yetanother").bindTo(another);
+    parser.option().bindTo(number);
+    parser.option().bindTo(positional);
+    parser.freeze();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(parser.isFrozen());
+    QCOMPARE(value, true);
+    QCOMPARE(option, std::string("file"));
+    QCOMPARE(another, 10);
+    QCOMPARE(positional, std::string("somefile"));
+    QCOMPARE(number, -5);
+    }
+
+    {
+    SCENARIO("Frozen parser finds every one of many long names")
+    cppcommandline::Parser parser;
+    std::vector<int> values(2000, 0);
+
+    for(std::size_t i = 0; i < values.size(); i++)
+        parser.option("option" + std::to_string(i)).bindTo(values[i]);
+
+    parser.freeze();
+
+    for(std::size_t i = 0; i < values.size(); i += 7)
+    {
+        std::string name = "--option" + std::to_string(i);
+        std::string value = std::to_string(i + 1);
+        std::vector<const char*> args{"./app", name.c_str(), value.c_str()};
+        parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+        QCOMPARE(values[i], static_cast<int>(i + 1));
+    }
+    }
+
+    {
+    SCENARIO("Frozen parser rejects unknown and repeated names")
+    cppcommandline::Parser parser;
+    int value = 0;
+    parser.option("value").asShortName("v").bindTo(value);
+    parser.freeze();
+    std::vector<const char*> unknown{"./app", "--valu", "1"};
+    std::vector<const char*> repeated{"./app", "-v", "1", "--value", "2"};
+    QVERIFY_EXCEPTION_THROWN(parser.parse(static_cast<int>(unknown.size()), const_cast<char**>(unknown.data())), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.parse(static_cast<int>(repeated.size()), const_cast<char**>(repeated.data())), std::logic_error);
+    }
+
+    {
+    SCENARIO("Frozen parser cannot be changed")
+    cppcommandline::Parser parser;
+    cppcommandline::Option &option = parser.option("value");
+    parser.freeze();
+    QVERIFY_EXCEPTION_THROWN(parser.option("other"), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(option.asShortName("v"), std::logic_error);
+    }
+}
+
+void CppCommandLineTest::frozenStorage()
+{
+    {
+    SCENARIO("Frozen parser checks required options")
+    std::vector<const char*> args{"./app", "--optional", "1"};
+    cppcommandline::Parser parser;
+    int optional = 0;
+    std::string positional;
+    parser.option("optional").bindTo(optional);
+    parser.option().required().bindTo(positional);
+    parser.freeze();
+    QVERIFY_EXCEPTION_THROWN(parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data())), std::logic_error);
+    }
+
+    {
+    SCENARIO("Frozen parser forgets matches of previous parses")
+    std::vector<const char*> args{"./app", "--value", "1", "file"};
+    cppcommandline::Parser parser;
+    int value = 0;
+    std::string positional;
+    parser.option("value").bindTo(value);
+    parser.option().required().bindTo(positional);
+    parser.freeze();
+
+    for(int i = 0; i < 3; i++)
+        parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+
+    QCOMPARE(value, 1);
+    QCOMPARE(positional, std::string("file"));
+    }
+
+    {
+    SCENARIO("Frozen option cannot be rebound but can be described")
+    cppcommandline::Parser parser;
+    int value = 0;
+    cppcommandline::Option &option = parser.option("value");
+    option.bindTo(value);
+    parser.freeze();
+    QVERIFY_EXCEPTION_THROWN(option.bindTo(value), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(option.required(), std::logic_error);
+    option.withDescription("Described after freezing");
+    QCOMPARE(option.description(), std::string("Described after freezing"));
+    }
+}
+
+void CppCommandLineTest::settings()
+{
+    {
+    SCENARIO("Parsing into settings leaves bound values untouched")
+    std::vector<const char*> args{"./app", "--threads", "8", "-v", "input"};
+    cppcommandline::Parser parser;
+    int boundThreads = 0;
+    parser.option("threads").withDefaultValue(4).bindTo(boundThreads);
+    parser.option("ratio").withDefaultValue(0.5);
+    parser.option("verbose").asShortName("v");
+    cppcommandline::Setting<int> threads = parser.setting<int>("threads");
+    cppcommandline::Setting<double> ratio = parser.setting<double>("ratio");
+    cppcommandline::Setting<bool> verbose = parser.setting<bool>("verbose");
+    cppcommandline::Setting<std::string> input = parser.setting<std::string>(parser.option());
+    std::unique_ptr<cppcommandline::Settings> settings = parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(boundThreads, 4);
+    QCOMPARE(settings->value(threads), 8);
+    QCOMPARE(settings->value(ratio), 0.5);
+    QCOMPARE(settings->value(verbose), true);
+    QCOMPARE(settings->value(input), std::string("input"));
+    QVERIFY(settings->isMatched(threads));
+    QVERIFY(!settings->isMatched(ratio));
+    }
+
+    {
+    SCENARIO("Setting type must match the option type")
+    cppcommandline::Parser parser;
+    parser.option("threads").withDefaultValue(4);
+    QVERIFY_EXCEPTION_THROWN(parser.setting<std::string>("threads"), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.setting<int>("unknown"), std::logic_error);
+    }
+
+    {
+    SCENARIO("Settings widen int options to long long like bindTo")
+    std::vector<const char*> args{"./app", "--size", "5000000000"};
+    cppcommandline::Parser parser;
+    parser.option("size").withDefaultValue(4).withRange(1, 8);
+    parser.option("offset").withDefaultValue(7);
+    cppcommandline::Setting<long long> size = parser.setting<long long>("size");
+    cppcommandline::Setting<long long> offset = parser.setting<long long>("offset");
+    QVERIFY_EXCEPTION_THROWN(parser.setting<double>("offset"), std::logic_error);
+    std::vector<const char*> none{"./app"};
+    std::unique_ptr<cppcommandline::Settings> settings = parser.parseSettings(static_cast<int>(none.size()), const_cast<char**>(none.data()));
+    QCOMPARE(settings->value(size), 4LL);
+    QCOMPARE(settings->value(offset), 7LL);
+    QVERIFY_EXCEPTION_THROWN(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())), std::logic_error);
+    args = {"./app", "--size", "8", "--offset", "5000000000"};
+    settings = parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(settings->value(size), 8LL);
+    QCOMPARE(settings->value(offset), 5000000000LL);
+    }
+
+    {
+    SCENARIO("Readers see consistent published settings while they are reloaded")
+    cppcommandline::Parser parser;
+    parser.option("first").withDefaultValue(0);
+    parser.option("second").withDefaultValue(0);
+    cppcommandline::Setting<int> first = parser.setting<int>("first");
+    cppcommandline::Setting<int> second = parser.setting<int>("second");
+    cppcommandline::SettingsPublisher publisher;
+    std::vector<const char*> args{"./app"};
+    publisher.publish(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())));
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+
+    std::thread reader([&]() {
+        cppcommandline::SettingsPublisher::Reader registration(publisher);
+
+        while(!done.load())
+        {
+            const cppcommandline::Settings *settings = registration.current();
+
+            if(settings->value(first) != settings->value(second))
+                ++torn;
+
+            registration.quiescent();
+        }
+    });
+
+    for(int i = 1; i <= 200; i++)
+    {
+        std::string value = std::to_string(i);
+        std::vector<const char*> reload{"./app", "--first", value.c_str(), "--second", value.c_str()};
+        publisher.publish(parser.parseSettings(static_cast<int>(reload.size()), const_cast<char**>(reload.data())));
+    }
+
+    done = true;
+    reader.join();
+    publisher.reclaim();
+    QCOMPARE(torn.load(), 0);
+    QCOMPARE(publisher.current()->value(first), 200);
+    QCOMPARE(publisher.retiredCount(), std::size_t(0));
+    }
+
+    {
+    SCENARIO("Retired settings are freed once every registered reader was quiescent")
+    cppcommandline::Parser parser;
+    parser.option("threads").withDefaultValue(1);
+    cppcommandline::Setting<int> threads = parser.setting<int>("threads");
+    cppcommandline::SettingsPublisher publisher;
+    std::vector<const char*> args{"./app", "--threads", "2"};
+    {
+        cppcommandline::SettingsPublisher::Reader reader(publisher);
+        publisher.publish(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())));
+        const cppcommandline::Settings *held = reader.current();
+        publisher.publish(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())));
+        QCOMPARE(publisher.retiredCount(), std::size_t(1));
+        QCOMPARE(held->value(threads), 2);
+        reader.quiescent();
+        publisher.reclaim();
+        QCOMPARE(publisher.retiredCount(), std::size_t(0));
+        held = reader.current();
+        publisher.publish(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())));
+        QCOMPARE(publisher.retiredCount(), std::size_t(1));
+        QCOMPARE(held->value(threads), 2);
+    }
+    publisher.reclaim();
+    QCOMPARE(publisher.retiredCount(), std::size_t(0));
+    }
+}
+
+void CppCommandLineTest::suggestions()
+{
+    cppcommandline::Parser parser;
+    bool verbose = false;
+    int threads = 0;
+    parser.option("verbose").asShortName("v").bindTo(verbose);
+    parser.option("threads").asShortName("t").bindTo(threads);
+
+    {
+    SCENARIO("Mistyped long name suggests the nearest long name")
+    QCOMPARE(parseError(parser, {"./app", "--verbos"}), std::string("No option matches argument '--verbos'. Did you mean '--verbose'?"));
+    QCOMPARE(parseError(parser, {"./app", "--thraeds=2"}), std::string("No option matches argument '--thraeds=2'. Did you mean '--threads'?"));
+    }
+
+    {
+    SCENARIO("Name with wrong prefix suggests the right prefix")
+    QCOMPARE(parseError(parser, {"./app", "-verbose"}), std::string("No option matches argument '-verbose'. Did you mean '--verbose'?"));
+    QCOMPARE(parseError(parser, {"./app", "--t", "2"}), std::string("No option matches argument '--t'. Did you mean '-t'?"));
+    }
+
+    {
+    SCENARIO("Distant or repeated names give no suggestion")
+    QCOMPARE(parseError(parser, {"./app", "--output"}), std::string("No option matches argument '--output'"));
+    QCOMPARE(parseError(parser, {"./app", "-v", "--verbose"}), std::string("No option matches argument '--verbose'"));
+    }
+
+    {
+    SCENARIO("One character names are only suggested for the same character")
+    QCOMPARE(parseError(parser, {"./app", "-x"}), std::string("No option matches argument '-x'"));
+    QCOMPARE(parseError(parser, {"./app", "--v"}), std::string("No option matches argument '--v'. Did you mean '-v'?"));
+    }
+
+    {
+    SCENARIO("Frozen parser suggests among many names")
+    cppcommandline::Parser generated;
+
+    for(int i = 0; i < 10000; i++)
+        generated.option("featureflag" + std::to_string(i));
+
+    generated.freeze();
+    QCOMPARE(parseError(generated, {"./app", "--featurflag1234"}), std::string("No option matches argument '--featurflag1234'. Did you mean '--featureflag1234'?"));
+    QCOMPARE(parseError(generated, {"./app", "--featureflga1234"}), std::string("No option matches argument '--featureflga1234'. Did you mean '--featureflag1234'?"));
+    QCOMPARE(parseError(generated, {"./app", "--faetureflgg77"}), std::string("No option matches argument '--faetureflgg77'"));
+    }
+}
+
+void CppCommandLineTest::abbreviations()
+{
+    {
+    SCENARIO("Unique prefix selects the long option")
+    std::vector<const char*> args{"./app", "--verb", "--thr=4", "--value", "3"};
+    cppcommandline::Parser parser;
+    bool verbose = false;
+    int threads = 0;
+    int value = 0;
+    int values = 0;
+    parser.option("verbose").bindTo(verbose);
+    parser.option("threads").bindTo(threads);
+    parser.option("value").bindTo(value);
+    parser.option("values").bindTo(values);
+    parser.enableAbbreviations();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(parser.abbreviationsEnabled());
+    QCOMPARE(verbose, true);
+    QCOMPARE(threads, 4);
+    QCOMPARE(value, 3);
+    QCOMPARE(values, 0);
+    }
+
+    {
+    SCENARIO("Ambiguous prefix lists the candidates")
+    cppcommandline::Parser parser;
+    bool verbose = false;
+    bool version = false;
+    parser.option("verbose").bindTo(verbose);
+    parser.option("version").bindTo(version);
+    parser.enableAbbreviations();
+    parser.freeze();
+    QCOMPARE(parseError(parser, {"./app", "--ver"}), std::string("Ambiguous option '--ver' could be: --verbose, --version"));
+    QCOMPARE(parseError(parser, {"./app", "--vers"}), std::string());
+    QCOMPARE(version, true);
+    }
+
+    {
+    SCENARIO("Abbreviations are disabled by default")
+    cppcommandline::Parser parser;
+    bool verbose = false;
+    parser.option("verbose").bindTo(verbose);
+    QVERIFY(!parser.abbreviationsEnabled());
+    QCOMPARE(parseError(parser, {"./app", "--verb"}), std::string("No option matches argument '--verb'"));
+    }
+}
+
+void CppCommandLineTest::reader()
+{
+    {
+    SCENARIO("Reader pulls tokens spanning chunk boundaries")
+    const char data[] = "--option=value\0\0last";
+    std::istringstream stream(std::string(data, sizeof(data) - 1));
+    cppcommandline::ArgumentReader reader(stream, '\0', 3);
+    QCOMPARE(std::string(reader.next()), std::string("--option=value"));
+    QCOMPARE(std::string(reader.next()), std::string());
+    QCOMPARE(std::string(reader.next()), std::string("last"));
+    QVERIFY(reader.next() == nullptr);
+    }
+
+    {
+    SCENARIO("Parser parses arguments streamed in small chunks")
+    const char data[] = "-v\0--option\0file\0--yetanother\0""10\0somefile\0";
+    std::istringstream stream(std::string(data, sizeof(data) - 1));
+    cppcommandline::ArgumentReader reader(stream, '\0', 4);
+    cppcommandline::Parser parser;
+    bool value = false;
+    std::string option;
+    int another = 0;
+    std::string positional;
+    parser.option("value").asShortName("v").bindTo(value);
+    parser.option("option").bindTo(option);
+    parser.option("yetanother").bindTo(another);
+    parser.option().required().bindTo(positional);
+    parser.parse(reader);
+    QCOMPARE(value, true);
+    QCOMPARE(option, std::string("file"));
+    QCOMPARE(another, 10);
+    QCOMPARE(positional, std::string("somefile"));
+    }
+
+    {
+    SCENARIO("Streamed option missing its value")
+    std::istringstream stream(std::string("--value\n"));
+    cppcommandline::ArgumentReader reader(stream, '\n');
+    cppcommandline::Parser parser;
+    int value = 0;
+    parser.option("value").bindTo(value);
+    QVERIFY_EXCEPTION_THROWN(parser.parse(reader), std::logic_error);
+    }
+
+    {
+    SCENARIO("Passthrough cannot be combined with streamed arguments")
+    std::istringstream stream(std::string("--value\n1\n--\nchild\n"));
+    cppcommandline::ArgumentReader reader(stream, '\n');
+    cppcommandline::Parser parser;
+    int value = 0;
+    parser.option("value").bindTo(value);
+    parser.setPassthrough(cppcommandline::Parser::Passthrough::AfterTerminator);
+    QVERIFY_EXCEPTION_THROWN(parser.parse(reader), std::logic_error);
+    QCOMPARE(value, 0);
+    }
+
+#ifndef _WIN32
+    {
+    SCENARIO("Parser parses arguments from a pipe")
+    int pipes[2];
+    QCOMPARE(pipe(pipes), 0);
+    const char data[] = "--count\0""42\0";
+    QCOMPARE(write(pipes[1], data, sizeof(data) - 1), static_cast<ssize_t>(sizeof(data) - 1));
+    close(pipes[1]);
+    cppcommandline::ArgumentReader reader(pipes[0]);
+    cppcommandline::Parser parser;
+    int count = 0;
+    parser.option("count").bindTo(count);
+    parser.freeze();
+    parser.parse(reader);
+    close(pipes[0]);
+    QCOMPARE(count, 42);
+    }
+#endif
+}
+
+void CppCommandLineTest::constraints()
+{
+    {
+    SCENARIO("Values outside of a range or the choices are rejected")
+    cppcommandline::Parser parser;
+    int threads = 0;
+    double ratio = 0;
+    std::string mode;
+    parser.option("threads").withRange(1, 64).bindTo(threads);
+    parser.option("ratio").withRange(0.0, 1.0).bindTo(ratio);
+    parser.option("mode").withChoices({"fast", "safe"}).bindTo(mode);
+    QCOMPARE(parseError(parser, {"./app", "--threads", "8", "--ratio=0.5", "--mode=safe"}), std::string());
+    QCOMPARE(threads, 8);
+    QCOMPARE(mode, std::string("safe"));
+    QCOMPARE(parseError(parser, {"./app", "--threads", "65"}), std::string("Value 65 of option 'threads' is out of range [1, 64]"));
+    QCOMPARE(parseError(parser, {"./app", "--ratio", "1.5"}), std::string("Value 1.5 of option 'ratio' is out of range [0, 1]"));
+    QCOMPARE(parseError(parser, {"./app", "--mode", "slow"}), std::string("Value 'slow' of option 'mode' is not one of: fast, safe"));
+    QVERIFY_EXCEPTION_THROWN(parser.option("empty").withRange(2, 1), std::logic_error);
+    static_assert(!HasRange<bool>::value && !HasRange<std::string>::value, "Only numeric options can have a range.");
+    static_assert(HasRange<int>::value && HasRange<long long>::value && HasRange<double>::value, "Numeric options can have a range.");
+    }
+
+    {
+    SCENARIO("Default values must match the range or the choices in either order")
+    cppcommandline::Parser parser;
+    QVERIFY_EXCEPTION_THROWN(parser.option("a").withRange(1, 10).withDefaultValue(5.0), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("b").withDefaultValue(5.0).withRange(1, 10), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("c").withChoices({"a", "b"}).withDefaultValue(3), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("d").withDefaultValue(3).withChoices({"a", "b"}), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("e").withRange(1, 10).withDefaultValue(20), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("f").withDefaultValue(20).withRange(1, 10), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("g").withChoices({"a", "b"}).withDefaultValue(std::string("bogus")), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("h").withDefaultValue(std::string("bogus")).withChoices({"a", "b"}), std::logic_error);
+    }
+
+    {
+    SCENARIO("Valid default values keep the range and the choices in either order")
+    cppcommandline::Parser parser;
+    int threads = 0;
+    long long size = 0;
+    std::string mode;
+    std::string level;
+    parser.option("threads").withRange(1, 10).withDefaultValue(5).bindTo(threads);
+    parser.option("size").withDefaultValue(5).withRange(1, 10).bindTo(size);
+    parser.option("mode").withChoices({"fast", "safe"}).withDefaultValue(std::string("safe")).bindTo(mode);
+    parser.option("level").withDefaultValue(std::string("low")).withChoices({"low", "high"}).bindTo(level);
+    QCOMPARE(parseError(parser, {"./app"}), std::string());
+    QCOMPARE(threads, 5);
+    QCOMPARE(size, 5LL);
+    QCOMPARE(mode, std::string("safe"));
+    QCOMPARE(level, std::string("low"));
+    QCOMPARE(parseError(parser, {"./app", "--threads", "7", "--size", "11"}), std::string("Value 11 of option 'size' is out of range [1, 10]"));
+    QCOMPARE(parseError(parser, {"./app", "--mode", "slow"}), std::string("Value 'slow' of option 'mode' is not one of: fast, safe"));
+    QCOMPARE(parseError(parser, {"./app", "--level", "mid"}), std::string("Value 'mid' of option 'level' is not one of: low, high"));
+    }
+
+    {
+    SCENARIO("The headers can be included in several translation units")
+    std::vector<const char*> args{"./app", "--threads", "4", "--sizes", "1,2"};
+    QCOMPARE(parseInSecondUnit(static_cast<int>(args.size()), const_cast<char**>(args.data())), 6);
+    }
+
+    {
+    SCENARIO("Exclusions and dependencies are checked against the matched options")
+    cppcommandline::Parser parser;
+    bool quiet = false;
+    bool verbose = false;
+    std::string log;
+    std::string level;
+    parser.option("quiet").excludes("verbose").bindTo(quiet);
+    parser.option("verbose").bindTo(verbose);
+    parser.option("level").dependsOn("log").bindTo(level);
+    parser.option("log").bindTo(log);
+    parser.freeze();
+    QCOMPARE(parseError(parser, {"./app", "--quiet", "--level", "debug", "--log", "file"}), std::string());
+    QCOMPARE(parseError(parser, {"./app", "--verbose", "--quiet"}), std::string("Option 'quiet' cannot be used together with 'verbose'"));
+    QCOMPARE(parseError(parser, {"./app", "--level", "debug"}), std::string("Option 'level' requires 'log'"));
+    QCOMPARE(parseError(parser, {"./app", "--verbose"}), std::string());
+    }
+
+    {
+    SCENARIO("Constraints on unknown options are reported")
+    cppcommandline::Parser parser;
+    parser.option("value").dependsOn("missing");
+    QVERIFY_EXCEPTION_THROWN(parser.freeze(), std::logic_error);
+    }
+}
+
+void CppCommandLineTest::numberLists()
+{
+    {
+    SCENARIO("Delimited lists are parsed into bound vectors")
+    cppcommandline::Parser parser;
+    std::vector<int> sizes;
+    std::vector<long long> offsets;
+    std::vector<double> weights;
+    parser.option("sizes").bindTo(sizes);
+    parser.option("offsets").withListDelimiter(':').bindTo(offsets);
+    parser.option("weights").bindTo(weights);
+    QCOMPARE(parseError(parser, {"./app", "--sizes", "1,-20,300", "--offsets=12345678901234:-9223372036854775808", "--weights", "0.1,-2.5,3,0.125"}), std::string());
+    QCOMPARE(sizes, (std::vector<int>{1, -20, 300}));
+    QCOMPARE(offsets, (std::vector<long long>{12345678901234ll, std::numeric_limits<long long>::min()}));
+    QCOMPARE(weights, (std::vector<double>{0.1, -2.5, 3.0, 0.125}));
+    }
+
+    {
+    SCENARIO("Malformed or overflowing elements do not match")
+    cppcommandline::NumberList list;
+    std::vector<int> integers;
+    std::vector<double> doubles;
+    QVERIFY(!list.parse("1,,2", 4, integers));
+    QVERIFY(!list.parse("1,2,", 4, integers));
+    QVERIFY(!list.parse("1,2a", 4, integers));
+    QVERIFY(!list.parse("2147483648", 10, integers));
+    QVERIFY(!list.parse("1.", 2, doubles));
+    QVERIFY(list.parse("", 0, integers));
+    QVERIFY(integers.empty());
+    cppcommandline::Parser parser;
+    parser.option("sizes").bindTo(integers);
+    QCOMPARE(parseError(parser, {"./app", "--sizes", "1,x"}), std::string("No option matches argument '--sizes'"));
+    }
+
+    {
+    SCENARIO("Long lists are split across threads into a caller buffer")
+    std::string text;
+    std::vector<double> expected;
+
+    for(int i = 0; i < 100000; i++)
+    {
+        std::string number = std::to_string(i % 7 ? i * 1.0625 : -i * 123456.789012345678);
+        text += (i ? "," : "") + number;
+        expected.push_back(std::strtod(number.c_str(), nullptr));
+    }
+
+    cppcommandline::NumberList list(',', 4);
+    std::vector<double> values(list.count(text.data(), text.size()));
+    QCOMPARE(values.size(), expected.size());
+    QVERIFY(list.parse(text.data(), text.size(), values.data()));
+    QVERIFY(values == expected);
+    }
+}
+
+void CppCommandLineTest::lazy()
+{
+    {
+    SCENARIO("Lazy values are converted on first access")
+    cppcommandline::Parser parser;
+    cppcommandline::Lazy<int> count;
+    cppcommandline::Lazy<double> ratio;
+    cppcommandline::Lazy<std::string> name;
+    cppcommandline::Lazy<bool> verbose;
+    parser.option("count").withDefaultValue(10).bindTo(count);
+    parser.option("ratio").bindTo(ratio);
+    parser.option("name").withDefaultValue(std::string("none")).bindTo(name);
+    parser.option("verbose").asShortName("v").bindTo(verbose);
+    QCOMPARE(count.value(), 10);
+    QCOMPARE(parseError(parser, {"./app", "--ratio", "0.5", "-v"}), std::string());
+    QVERIFY(!count.isMatched());
+    QVERIFY(ratio.isMatched());
+    QCOMPARE(count.value(), 10);
+    QCOMPARE(ratio.value(), 0.5);
+    QCOMPARE(name.value(), std::string("none"));
+    QCOMPARE(static_cast<bool>(verbose), true);
+    QVERIFY(parser.option("count").boundValue<int>() == nullptr);
+    }
+
+    {
+    SCENARIO("Lazy values keep the matching and error semantics of eager bindings")
+    cppcommandline::Parser parser;
+    cppcommandline::Lazy<int> count;
+    parser.option("count").bindTo(count);
+    parser.freeze();
+    QCOMPARE(parseError(parser, {"./app", "--count", "many"}), std::string("No option matches argument '--count'"));
+    QCOMPARE(parseError(parser, {"./app", "--count", "99999999999"}), std::string());
+    QVERIFY_EXCEPTION_THROWN(count.value(), std::out_of_range);
+    QCOMPARE(parseError(parser, {"./app", "--count=42"}), std::string());
+    QCOMPARE(count.value(), 42);
+    }
+
+    {
+    SCENARIO("Parsing into settings does not touch lazy bindings")
+    cppcommandline::Parser parser;
+    cppcommandline::Lazy<int> count;
+    cppcommandline::Lazy<bool> verbose;
+    parser.option("count").bindTo(count);
+    parser.option("verbose").asShortName("v").bindTo(verbose);
+    cppcommandline::Setting<int> countSetting = parser.setting<int>("count");
+    cppcommandline::Setting<bool> verboseSetting = parser.setting<bool>("verbose");
+    std::vector<const char*> args{"./app", "--count", "7", "-v"};
+    std::unique_ptr<cppcommandline::Settings> settings = parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(settings->value(countSetting), 7);
+    QCOMPARE(settings->value(verboseSetting), true);
+    QVERIFY(!count.isMatched());
+    QVERIFY(!verbose.isMatched());
+    QCOMPARE(parseError(parser, {"./app", "--count", "8", "-v"}), std::string());
+    QCOMPARE(count.value(), 8);
+    QCOMPARE(static_cast<bool>(verbose), true);
+    }
+
+    {
+    SCENARIO("Lazy and eager bindings accept the same default values")
+    cppcommandline::Parser parser;
+    cppcommandline::Lazy<long long> seed;
+    long long offset = 0;
+    parser.option("seed").withDefaultValue(1).bindTo(seed);
+    parser.option("offset").withDefaultValue(2).bindTo(offset);
+    QCOMPARE(seed.value(), 1ll);
+    QCOMPARE(offset, 2ll);
+    QCOMPARE(parseError(parser, {"./app", "--seed", "5000000000", "--offset", "6000000000"}), std::string());
+    QCOMPARE(seed.value(), 5000000000ll);
+    QCOMPARE(offset, 6000000000ll);
+    cppcommandline::Lazy<int> count;
+    int eager = 0;
+    QVERIFY_EXCEPTION_THROWN(parser.option("count").withDefaultValue(1.5).bindTo(count), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(parser.option("eager").withDefaultValue(1.5).bindTo(eager), std::logic_error);
+    }
+
+    {
+    SCENARIO("Lazily bound options cannot have value constraints")
+    cppcommandline::Parser parser;
+    cppcommandline::Lazy<int> count;
+    QVERIFY_EXCEPTION_THROWN(parser.option("count").withRange(1, 2).bindTo(count), std::logic_error);
+    }
+}
+
+void CppCommandLineTest::stringPool()
+{
+    {
+    SCENARIO("Options keep their own names until the pool is enabled")
+    const std::size_t count = cppcommandline::StringPool::instance().count();
+    cppcommandline::Parser first;
+    cppcommandline::Parser second;
+    first.option("unpooled").withDescription("Not interned");
+    second.option("unpooled").withDescription("Not interned");
+    QCOMPARE(cppcommandline::StringPool::instance().count(), count);
+    cppcommandline::Dispatcher dispatcher;
+    dispatcher.add(first);
+    QVERIFY_EXCEPTION_THROWN(dispatcher.add(second), std::logic_error);
+    }
+
+    cppcommandline::StringPool::enable();
+
+    {
+    SCENARIO("Equal strings are interned once")
+    cppcommandline::StringPool &pool = cppcommandline::StringPool::instance();
+    cppcommandline::InternedString first = pool.intern(std::string("poolname"));
+    const std::size_t copied = pool.copiedBytes();
+    cppcommandline::InternedString second = pool.intern(std::string("pool") + "name");
+    QVERIFY(first == second);
+    QVERIFY(first.data() == second.data());
+    QCOMPARE(pool.copiedBytes(), copied);
+    QVERIFY(first != pool.intern(std::string("poolnames")));
+    QCOMPARE(pool.intern(std::string()).id(), static_cast<std::uint32_t>(0));
+    }
+
+    {
+    SCENARIO("String literals are interned without copying")
+    static const char description[] = "A long description that is shared by the options of many parsers";
+    cppcommandline::StringPool &pool = cppcommandline::StringPool::instance();
+    const std::size_t copied = pool.copiedBytes();
+    cppcommandline::Parser first;
+    cppcommandline::Parser second;
+    first.option(cppcommandline::literal("pooledoption")).withDescription(cppcommandline::literal(description));
+    second.option(cppcommandline::literal("pooledoption")).withDescription(cppcommandline::literal(description));
+    QCOMPARE(pool.copiedBytes(), copied);
+    QCOMPARE(pool.intern(std::string(description)).data(), description);
+    }
+
+    {
+    SCENARIO("Strings interned from many threads get one id")
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::uint32_t>> ids(4);
+
+    for(std::size_t t = 0; t < ids.size(); t++)
+    {
+        threads.emplace_back([&ids, t]() {
+            for(int i = 0; i < 1000; i++)
+                ids[t].push_back(cppcommandline::StringPool::instance().intern("threadname" + std::to_string(i)).id());
+        });
+    }
+
+    for(std::thread &thread : threads)
+        thread.join();
+
+    for(std::size_t t = 1; t < ids.size(); t++)
+        QVERIFY(ids[t] == ids[0]);
+    }
+}
+
+void CppCommandLineTest::helpSearch()
+{
+    cppcommandline::Parser parser;
+    std::string output;
+    parser.setOutput([&](const std::string &text) { output += text; });
+    parser.option("threads").asShortName("t").withDescription("Number of worker threads").inGroup("Performance");
+    parser.option("cache").withDescription("Size of the block cache").inGroup("Performance");
+    parser.option("host").withDescription("Server host name").inGroup("Network");
+    parser.option("port").withDescription("Server port").inGroup("Network");
+    parser.option("verbose").asShortName("v").withDescription("Print every step");
+
+    {
+    SCENARIO("Help for a term lists every option unless the help index is enabled")
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--help=port"}), std::string());
+    QCOMPARE(output.substr(0, 30), std::string("Usage: app [options]\nOptions:\n"));
+    QVERIFY(output.find("--threads") != std::string::npos);
+    }
+
+    cppcommandline::HelpIndex::enable(parser);
+
+    {
+    SCENARIO("Full help lists ungrouped options first and then every group")
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--help"}), std::string());
+    QCOMPARE(output, std::string("Usage: app [options]\n"
+                                 "Options:\n"
+                                 "    -v, --verbose        [optional]          Print every step\n"
+                                 "\n"
+                                 "Performance:\n"
+                                 "    -t, --threads        [optional]          Number of worker threads\n"
+                                 "    -, --cache           [optional]          Size of the block cache\n"
+                                 "\n"
+                                 "Network:\n"
+                                 "    -, --host            [optional]          Server host name\n"
+                                 "    -, --port            [optional]          Server port\n"
+                                 "\n"));
+    }
+
+    {
+    SCENARIO("Help for a term lists the options whose words start with every word of the term")
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--help=server PO"}), std::string());
+    QCOMPARE(output, std::string("Usage: app [options]\n"
+                                 "Options matching 'server PO':\n"
+                                 "\n"
+                                 "Network:\n"
+                                 "    -, --port            [optional]          Server port\n"
+                                 "\n"));
+    QVERIFY(parser.helpDisplayed());
+    }
+
+    {
+    SCENARIO("Help for a group name lists the group")
+    parser.freeze();
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--help=Performance"}), std::string());
+    QCOMPARE(output, std::string("Usage: app [options]\n"
+                                 "Options matching 'Performance':\n"
+                                 "\n"
+                                 "Performance:\n"
+                                 "    -t, --threads        [optional]          Number of worker threads\n"
+                                 "    -, --cache           [optional]          Size of the block cache\n"
+                                 "\n"));
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--help=gpu"}), std::string());
+    QCOMPARE(output, std::string("Usage: app [options]\nNo options match 'gpu'.\n\n"));
+    }
+}
+
+void CppCommandLineTest::passthrough()
+{
+    {
+    SCENARIO("Arguments after the terminator are passed through in place")
+    std::vector<const char*> args{"./wrapper", "-v", "--", "child", "--help", nullptr};
+    cppcommandline::Parser parser;
+    bool verbose = false;
+    parser.option("verbose").asShortName("v").bindTo(verbose);
+    parser.setPassthrough(cppcommandline::Parser::Passthrough::AfterTerminator);
+    parser.parse(static_cast<int>(args.size()) - 1, const_cast<char**>(args.data()));
+    QCOMPARE(verbose, true);
+    QVERIFY(!parser.helpDisplayed());
+    QVERIFY(parser.passthroughArguments() == const_cast<char**>(args.data()) + 3);
+    QCOMPARE(parser.passthroughCount(), 2);
+    QVERIFY(parser.passthroughArguments()[2] == nullptr);
+    args.erase(args.begin() + 2, args.end() - 1);
+    parser.parse(static_cast<int>(args.size()) - 1, const_cast<char**>(args.data()));
+    QCOMPARE(parser.passthroughCount(), 0);
+    }
+
+    {
+    SCENARIO("Passthrough can start at the first unmatched positional argument")
+    char blob[] = "./wrapper\n--threads\n2\nchild\n--threads\n4\n";
+    cppcommandline::Parser parser;
+    int threads = 0;
+    parser.option("threads").bindTo(threads);
+    parser.setPassthrough(cppcommandline::Parser::Passthrough::FromFirstUnmatched);
+    parser.freeze();
+    parser.parse(blob, sizeof(blob) - 1, '\n');
+    QCOMPARE(threads, 2);
+    QCOMPARE(parser.passthroughCount(), 3);
+    QCOMPARE(std::string(parser.passthroughArguments()[0]), std::string("child"));
+    QVERIFY(parser.passthroughArguments()[3] == nullptr);
+    QCOMPARE(parseError(parser, {"./wrapper", "--thread", "child"}), std::string("No option matches argument '--thread'. Did you mean '--threads'?"));
+    }
+}
+
+void CppCommandLineTest::dispatcher()
+{
+    cppcommandline::Parser logging;
+    cppcommandline::Parser rpc;
+    cppcommandline::Parser application;
+    std::string level;
+    int port = 0;
+    bool verbose = false;
+    std::string file;
+    logging.option("loglevel").asShortName("l").withDescription("Log level").bindTo(level);
+    rpc.option("port").asShortName("p").required().withDescription("RPC port").bindTo(port);
+    application.option("verbose").asShortName("v").bindTo(verbose);
+    application.option().bindTo(file);
+    cppcommandline::Dispatcher dispatcher;
+    std::string output;
+    dispatcher.setOutput([&](const std::string &text) { output += text; });
+    dispatcher.add(logging);
+    dispatcher.add(rpc);
+    dispatcher.add(application);
+
+    for(cppcommandline::Parser *parser : {&logging, &rpc, &application})
+        cppcommandline::HelpIndex::enable(*parser);
+
+    {
+    SCENARIO("Every argument is routed to the parser declaring it")
+    std::vector<const char*> args{"./app", "-p", "8080", "input", "--loglevel=debug", "-v"};
+    dispatcher.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(level, std::string("debug"));
+    QCOMPARE(port, 8080);
+    QCOMPARE(verbose, true);
+    QCOMPARE(file, std::string("input"));
+    QCOMPARE(rpc.applicationName(), std::string("app"));
+    }
+
+    {
+    SCENARIO("Unknown and missing arguments are reported once")
+    std::vector<const char*> unknown{"./app", "--port", "1", "--loglevle", "info"};
+    output.clear();
+    QVERIFY_EXCEPTION_THROWN(dispatcher.parse(static_cast<int>(unknown.size()), const_cast<char**>(unknown.data())), std::logic_error);
+    QCOMPARE(output, std::string("Error parsing command line arguments: No option matches argument '--loglevle'. Did you mean '--loglevel'?\n"
+                                 "Use --help or -h to list the command line options.\n"));
+    std::vector<const char*> missing{"./app", "-v"};
+    QVERIFY_EXCEPTION_THROWN(dispatcher.parse(static_cast<int>(missing.size()), const_cast<char**>(missing.data())), std::logic_error);
+    }
+
+    {
+    SCENARIO("Help lists the options of every parser")
+    std::vector<const char*> args{"./app", "--help=port"};
+    output.clear();
+    dispatcher.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(dispatcher.helpDisplayed());
+    QCOMPARE(output, std::string("Usage: app [options]\n"
+                                 "Options matching 'port':\n"
+                                 "    -p, --port           [required]          RPC port\n"
+                                 "\n"));
+    args = {"./app", "-p", "1"};
+    dispatcher.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(!dispatcher.helpDisplayed());
+    QVERIFY(!rpc.helpDisplayed());
+    }
+
+    {
+    SCENARIO("Name collisions are reported at registration")
+    cppcommandline::Parser storage;
+    storage.option("port").bindTo(port);
+    QVERIFY_EXCEPTION_THROWN(dispatcher.add(storage), std::logic_error);
+    cppcommandline::Parser shortName;
+    shortName.option("level").asShortName("l");
+    QVERIFY_EXCEPTION_THROWN(dispatcher.add(shortName), std::logic_error);
+    cppcommandline::Parser positional;
+    positional.option();
+    QVERIFY_EXCEPTION_THROWN(dispatcher.add(positional), std::logic_error);
+    }
+
+    {
+    SCENARIO("Help arguments reach the parser that declares them")
+    cppcommandline::Parser custom;
+    cppcommandline::Parser server;
+    bool help = false;
+    int threads = 0;
+    custom.disableHelp();
+    custom.option("help").bindTo(help);
+    server.option("threads").bindTo(threads);
+    cppcommandline::Dispatcher own;
+    std::string text;
+    own.setOutput([&](const std::string &written) { text += written; });
+    own.add(custom);
+    own.add(server);
+    std::vector<const char*> args{"./app", "--help", "--threads", "2"};
+    own.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(help);
+    QCOMPARE(threads, 2);
+    QVERIFY(!own.helpDisplayed());
+    args = {"./app", "-h"};
+    own.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(own.helpDisplayed());
+    }
+
+    {
+    SCENARIO("Help is not offered when every parser disabled it")
+    cppcommandline::Parser quiet;
+    int threads = 0;
+    quiet.disableHelp();
+    quiet.option("threads").bindTo(threads);
+    cppcommandline::Dispatcher plain;
+    std::string text;
+    plain.setOutput([&](const std::string &written) { text += written; });
+    plain.add(quiet);
+    std::vector<const char*> args{"./app", "-h"};
+    QVERIFY_EXCEPTION_THROWN(plain.parse(static_cast<int>(args.size()), const_cast<char**>(args.data())), std::logic_error);
+    QVERIFY(!plain.helpDisplayed());
+    QCOMPARE(text, std::string("Error parsing command line arguments: No option matches argument '-h'\n"));
+    }
+}
+
+void CppCommandLineTest::trace()
+{
+    const std::string fileName = "cppcommandlinetest.trace";
+
+    {
+    SCENARIO("Recorded arguments, environment and configuration are read back")
+    const char *environment[] = {"HOME=/root", "LANG=C", nullptr};
+    const std::string configuration = "threads = 4\n";
+    cppcommandline::Parser parser;
+    int threads = 0;
+    parser.option("threads").bindTo(threads);
+
+    {
+    cppcommandline::TraceRecorder recorder(fileName, 1, 16);
+    recorder.recordEnvironment(const_cast<char**>(environment));
+    recorder.recordConfiguration(configuration.data(), configuration.size());
+    std::vector<const char*> args{"./app", "--threads", "2", nullptr};
+    recorder.parse(parser, static_cast<int>(args.size()) - 1, const_cast<char**>(args.data()));
+    QCOMPARE(threads, 2);
+    }
+
+    cppcommandline::TraceReader reader(fileName);
+    cppcommandline::TraceRecord record;
+    QVERIFY(reader.next(record));
+    QVERIFY(record.kind() == cppcommandline::TraceRecord::Kind::Environment);
+    QCOMPARE(record.count(), 2);
+    QCOMPARE(std::string(record.arguments()[1]), std::string("LANG=C"));
+    QVERIFY(reader.next(record));
+    QVERIFY(record.kind() == cppcommandline::TraceRecord::Kind::Configuration);
+    QCOMPARE(std::string(record.arguments()[0]), configuration);
+    QVERIFY(reader.next(record));
+    QVERIFY(record.kind() == cppcommandline::TraceRecord::Kind::Arguments);
+    QCOMPARE(record.count(), 3);
+    QVERIFY(record.arguments()[3] == nullptr);
+    threads = 0;
+    parser.parse(record.count(), record.arguments());
+    QCOMPARE(threads, 2);
+    QVERIFY(!reader.next(record));
+    }
+
+    {
+    SCENARIO("Only every n-th argument vector is recorded")
+    {
+    cppcommandline::TraceRecorder recorder(fileName, 3);
+
+    for(int i = 0; i < 7; i++)
+    {
+        const std::string value = std::to_string(i);
+        std::vector<const char*> args{"./app", value.c_str(), nullptr};
+        recorder.record(static_cast<int>(args.size()) - 1, const_cast<char**>(args.data()));
+    }
+    }
+
+    cppcommandline::TraceReader reader(fileName);
+    cppcommandline::TraceRecord record;
+    std::string recorded;
+
+    while(reader.next(record))
+        recorded += record.arguments()[1];
+
+    QCOMPARE(recorded, std::string("036"));
+    }
+
+    {
+    SCENARIO("Files that are not complete traces are rejected")
+    {
+    cppcommandline::TraceRecorder recorder(fileName);
+    std::vector<const char*> args{"./app", "--threads", "2", nullptr};
+    recorder.record(static_cast<int>(args.size()) - 1, const_cast<char**>(args.data()));
+    }
+
+    std::string data;
+    {
+    std::FILE *file = std::fopen(fileName.c_str(), "rb");
+    char buffer[256];
+    data.append(buffer, std::fread(buffer, 1, sizeof(buffer), file));
+    std::fclose(file);
+    }
+
+    std::FILE *file = std::fopen(fileName.c_str(), "wb");
+    std::fwrite(data.data(), 1, data.size() - 1, file);
+    std::fclose(file);
+    cppcommandline::TraceReader truncated(fileName);
+    cppcommandline::TraceRecord record;
+    QVERIFY_EXCEPTION_THROWN(truncated.next(record), std::runtime_error);
+
+    file = std::fopen(fileName.c_str(), "wb");
+    std::fwrite("CLT0", 1, 4, file);
+    std::fclose(file);
+    QVERIFY_EXCEPTION_THROWN(cppcommandline::TraceReader reader(fileName), std::runtime_error);
+    }
+
+#ifdef __linux__
+    {
+    SCENARIO("Failed writes are reported by flush() but not thrown from the destructor")
+    std::vector<const char*> args{"./app", "--input", "data.bin"};
+    cppcommandline::TraceRecorder recorder("/dev/full");
+    recorder.record(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY_EXCEPTION_THROWN(recorder.flush(), std::runtime_error);
+    recorder.record(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    }
+#endif
+
+    std::remove(fileName.c_str());
+}
+
+void CppCommandLineTest::tuples()
+{
+    {
+    SCENARIO("Options with a fixed arity consume that many values")
+    std::vector<const char*> args{"./app", "--origin", "1.0", "-2.5", "3.0", "--limits=4", "8192", "-n", "x", "-7", "input"};
+    cppcommandline::Parser parser;
+    std::array<double, 3> origin{{0.0, 0.0, 0.0}};
+    std::pair<int, long long> limits(0, 0);
+    std::tuple<std::string, int> node;
+    std::string input;
+    parser.option("origin").bindTo(origin);
+    parser.option("limits").bindTo(limits);
+    parser.option("node").asShortName("n").bindTo(node);
+    parser.option().bindTo(input);
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(origin[0], 1.0);
+    QCOMPARE(origin[1], -2.5);
+    QCOMPARE(origin[2], 3.0);
+    QCOMPARE(limits.first, 4);
+    QCOMPARE(limits.second, 8192ll);
+    QCOMPARE(std::get<0>(node), std::string("x"));
+    QCOMPARE(std::get<1>(node), -7);
+    QCOMPARE(input, std::string("input"));
+    }
+
+    {
+    SCENARIO("Parsing numeric tuples does not allocate")
+    std::vector<const char*> args{"./app", "--origin", "1.0", "2.0", "3.0", "--limits", "4", "8192"};
+    cppcommandline::Parser parser;
+    std::array<double, 3> origin{{0.0, 0.0, 0.0}};
+    std::pair<int, int> limits(0, 0);
+    parser.option("origin").bindTo(origin);
+    parser.option("limits").bindTo(limits);
+    parser.freeze();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    std::size_t before = allocationCount();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(allocationCount(), before);
+    QCOMPARE(origin[2], 3.0);
+    QCOMPARE(limits.second, 8192);
+    }
+
+    {
+    SCENARIO("Missing or mistyped values are reported")
+    cppcommandline::Parser parser;
+    std::pair<int, int> limits(0, 0);
+    parser.option("limits").bindTo(limits);
+    QCOMPARE(parseError(parser, {"./app", "--limits", "4"}), std::string("Missing value for option 'limits'"));
+    QCOMPARE(parseError(parser, {"./app", "--limits", "4", "many"}), std::string("No option matches argument '--limits'"));
+    QCOMPARE(limits.first, 0);
+    std::vector<const char*> args{"./app", "--limits", "4", "8"};
+    QVERIFY_EXCEPTION_THROWN(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())), std::logic_error);
+    }
+
+    {
+    SCENARIO("Options with multiple values cannot be parsed from an ArgumentReader")
+    cppcommandline::Parser parser;
+    std::pair<int, int> limits(0, 0);
+    parser.option("limits").bindTo(limits);
+    const char data[] = "--limits\0" "4\0" "8\0";
+    std::istringstream stream(std::string(data, sizeof(data) - 1));
+    cppcommandline::ArgumentReader reader(stream);
+    std::string output;
+    parser.setOutput([&](const std::string &text) { output += text; });
+    QVERIFY_EXCEPTION_THROWN(parser.parse(reader), std::logic_error);
+    QCOMPARE(limits.first, 0);
+    QVERIFY(output.empty());
+    }
+
+    {
+    SCENARIO("Positional and already typed options cannot take multiple values")
+    std::pair<int, int> limits(0, 0);
+    QVERIFY_EXCEPTION_THROWN(cppcommandline::Option().bindTo(limits), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(cppcommandline::Option("limits").withDefaultValue(1).bindTo(limits), std::logic_error);
+    }
+}
+
+void CppCommandLineTest::server()
+{
+#ifndef _WIN32
+    const std::string path = "cppcommandlinetest.socket";
+    cppcommandline::Parser parser;
+    std::string input;
+    std::vector<int> sizes;
+    parser.option().required().bindTo(input);
+    parser.option("threads").asShortName("t").withDefaultValue(1).withRange(1, 64).withDescription("Worker threads");
+    parser.option("ratio").withDefaultValue(0.5);
+    parser.option("verbose").asShortName("v").withDefaultValue(false);
+    parser.option("sizes").bindTo(sizes);
+    cppcommandline::ParseServer server(parser, path);
+    std::thread thread([&]() { server.serve(); });
+    cppcommandline::ParseClient client(path);
+
+    {
+    SCENARIO("Warm server returns typed values of a parse")
+    std::vector<const char*> args{"./tool", "-t", "8", "--sizes", "1,2,3", "-v", "input.txt"};
+    cppcommandline::ParseResult result = client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(result.status() == cppcommandline::ParseResult::Status::Parsed);
+    QCOMPARE(result.count(), std::size_t(5));
+    QCOMPARE(result.value<std::string>(0), std::string("input.txt"));
+    QCOMPARE(result.value<int>("threads"), 8);
+    QCOMPARE(result.isMatched("ratio"), false);
+    QCOMPARE(result.value<double>("ratio"), 0.5);
+    QCOMPARE(result.value<bool>("verbose"), true);
+    QCOMPARE(result.value<std::vector<int>>("sizes"), (std::vector<int>{1, 2, 3}));
+    QVERIFY_EXCEPTION_THROWN(result.value<long long>("threads"), std::logic_error);
+    QVERIFY_EXCEPTION_THROWN(result.value<int>("missing"), std::logic_error);
+    }
+
+    {
+    SCENARIO("Errors and help are returned as messages")
+    std::vector<const char*> args{"./tool", "-t", "65", "input.txt"};
+    cppcommandline::ParseResult result = client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(result.status() == cppcommandline::ParseResult::Status::Error);
+    QCOMPARE(result.message(), std::string("Value 65 of option 'threads' is out of range [1, 64]"));
+    QCOMPARE(result.count(), std::size_t(0));
+    args = {"./tool", "--help"};
+    result = client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(result.status() == cppcommandline::ParseResult::Status::Help);
+    QVERIFY(result.message().find("Worker threads") != std::string::npos);
+    args = {"./tool", "input.txt"};
+    result = client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(result.status() == cppcommandline::ParseResult::Status::Parsed);
+    QCOMPARE(result.count(), std::size_t(5));
+    }
+
+    {
+    SCENARIO("Concurrent clients are served while another client stalls")
+    const sockaddr_un address = cppcommandline::ParseSocket::address(path);
+    cppcommandline::ParseSocket stalled(::socket(AF_UNIX, SOCK_STREAM, 0));
+    QCOMPARE(::connect(stalled.handle(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    std::atomic<int> parsed{0};
+    std::vector<std::thread> clients;
+
+    for(int i = 1; i <= 8; i++)
+    {
+        clients.emplace_back([&, i]() {
+            for(int j = 0; j < 20; j++)
+            {
+                const std::string threads = std::to_string(i);
+                const std::string file = "input" + std::to_string(j) + ".txt";
+                std::vector<const char*> args{"./tool", "-t", threads.c_str(), file.c_str()};
+                cppcommandline::ParseResult result = client.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+
+                if(result.status() == cppcommandline::ParseResult::Status::Parsed && result.value<int>("threads") == i && result.value<std::string>(0) == file)
+                    ++parsed;
+            }
+        });
+    }
+
+    for(std::thread &worker : clients)
+        worker.join();
+
+    QCOMPARE(parsed.load(), 160);
+    }
+
+    server.stop();
+    thread.join();
+
+    {
+    SCENARIO("Stalled clients time out")
+    const std::string timeoutPath = "cppcommandlinetest.timeout.socket";
+    cppcommandline::ParseServer single(parser, timeoutPath, 1, std::chrono::milliseconds(100));
+    std::thread singleThread([&]() { single.serve(); });
+    const sockaddr_un address = cppcommandline::ParseSocket::address(timeoutPath);
+    cppcommandline::ParseSocket stalled(::socket(AF_UNIX, SOCK_STREAM, 0));
+    QCOMPARE(::connect(stalled.handle(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    std::vector<const char*> args{"./tool", "input.txt"};
+    cppcommandline::ParseResult result = cppcommandline::ParseClient(timeoutPath).parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(result.status() == cppcommandline::ParseResult::Status::Parsed);
+    single.stop();
+    singleThread.join();
+    }
+
+    {
+    SCENARIO("The parser keeps writing to its own output after the server is gone")
+    std::string output;
+    parser.setOutput([&](const std::string &text) { output += text; });
+    {
+        cppcommandline::ParseServer temporary(parser, path);
+    }
+    std::vector<const char*> args{"./tool", "--help"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(output.find("Worker threads") != std::string::npos);
+    }
+
+    {
+    SCENARIO("Files other than sockets are not replaced by the server")
+    const std::string fileName = "cppcommandlinetest.notasocket";
+    std::FILE *file = std::fopen(fileName.c_str(), "w");
+    QVERIFY(file != nullptr);
+    std::fclose(file);
+    QVERIFY_EXCEPTION_THROWN(cppcommandline::ParseServer(parser, fileName), std::runtime_error);
+    file = std::fopen(fileName.c_str(), "r");
+    QVERIFY(file != nullptr);
+    std::fclose(file);
+    std::remove(fileName.c_str());
+    }
+#endif
+}
+
+void CppCommandLineTest::actions()
+{
+    {
+    SCENARIO("Actions run as soon as their option is converted")
+    std::vector<const char*> args{"./app", "--model", "model.bin", "--threads", "4", "input"};
+    cppcommandline::Parser parser;
+    std::string model;
+    int threads = 0;
+    std::string input;
+    std::vector<std::string> loaded;
+    parser.option("model").onMatch([&](const cppcommandline::CancellationToken &) { loaded.push_back(model + " " + std::to_string(threads)); }).bindTo(model);
+    parser.option("threads").bindTo(threads);
+    parser.option().onMatch([&](const cppcommandline::CancellationToken &token) { loaded.push_back(input + (token.isCancelled() ? " cancelled" : "")); }).bindTo(input);
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(loaded, (std::vector<std::string>{"model.bin 0", "input"}));
+    parser.freeze();
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(loaded.size(), std::size_t(4));
+    }
+
+    {
+    SCENARIO("Actions dispatched to an executor are cancelled when the parse fails")
+    cppcommandline::Parser parser;
+    std::string index;
+    int threads = 0;
+    std::vector<std::function<void()>> tasks;
+    std::vector<bool> cancelled;
+    parser.option("index").onMatch([&](const cppcommandline::CancellationToken &token) { cancelled.push_back(token.isCancelled()); }).bindTo(index);
+    parser.option("threads").withRange(1, 64).withDefaultValue(1).bindTo(threads);
+    parser.setExecutor([&](std::function<void()> task) { tasks.push_back(std::move(task)); });
+    parser.freeze();
+    QCOMPARE(parseError(parser, {"./app", "--index", "words.idx", "--threads", "100"}), std::string("Value 100 of option 'threads' is out of range [1, 64]"));
+    std::vector<const char*> args{"./app", "--index", "words.idx"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(tasks.size(), std::size_t(2));
+
+    for(std::function<void()> &task : tasks)
+        task();
+
+    QCOMPARE(cancelled, (std::vector<bool>{true, false}));
+    }
+
+    {
+    SCENARIO("Parsing into settings does not run actions")
+    cppcommandline::Parser parser;
+    int calls = 0;
+    parser.option("index").withDefaultValue(std::string()).onMatch([&](const cppcommandline::CancellationToken &) { calls++; });
+    std::vector<const char*> args{"./app", "--index", "words.idx"};
+    parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(calls, 0);
+    }
+}
+
+void CppCommandLineTest::schema()
+{
+    {
+    SCENARIO("Frozen schema is packed into whole pages and can be protected")
+    cppcommandline::Parser parser;
+    std::vector<int> values(1000, 0);
+
+    for(std::size_t i = 0; i < values.size(); i++)
+        parser.option("option" + std::to_string(i)).bindTo(values[i]);
+
+    QCOMPARE(parser.schemaSize(), std::size_t(0));
+    QVERIFY_EXCEPTION_THROWN(parser.protectSchema(), std::logic_error);
+    parser.option("required").required().bindTo(values[0]);
+    parser.freeze();
+    QVERIFY(parser.schemaSize() > 0);
+#ifndef _WIN32
+    QCOMPARE(parser.schemaSize() % static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)), std::size_t(0));
+    parser.protectSchema();
+#endif
+    std::vector<const char*> args{"./app", "--option999", "9", "--required", "1"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(values[999], 9);
+    QCOMPARE(values[0], 1);
+    QCOMPARE(parseError(parser, {"./app", "--requird", "1"}), std::string("No option matches argument '--requird'. Did you mean '--required'?"));
+    QCOMPARE(parseError(parser, {"./app"}), std::string("Option 'required' was set as required but did not match any arguments"));
+    }
+
+#ifndef _WIN32
+    {
+    SCENARIO("Forked workers parse with the protected schema of the master")
+    cppcommandline::Parser parser;
+    int threads = 0;
+    std::string input;
+    parser.option("threads").withRange(1, 64).bindTo(threads);
+    parser.option().required().bindTo(input);
+    parser.freeze();
+    parser.protectSchema();
+    const pid_t pid = ::fork();
+
+    if(pid == 0)
+    {
+        std::vector<const char*> args{"./worker", "--threads", "8", "input"};
+        parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+        ::_exit(threads == 8 && input == "input" ? 0 : 1);
+    }
+
+    int status = -1;
+    QVERIFY(pid > 0);
+    QCOMPARE(::waitpid(pid, &status, 0), pid);
+    QVERIFY(WIFEXITED(status));
+    QCOMPARE(WEXITSTATUS(status), 0);
+    QCOMPARE(threads, 0);
+    }
+#endif
+}
+
+void CppCommandLineTest::blobs()
+{
+    {
+    SCENARIO("Hex and base64 of any length decode to the encoded bytes")
+    const char *hexDigits = "0123456789abcdef";
+    const char *base64Digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for(std::size_t size = 0; size < 100; size++)
+    {
+        std::string bytes;
+        std::string hex;
+        std::string base64;
+
+        for(std::size_t i = 0; i < size; i++)
+            bytes.push_back(static_cast<char>(i * 37 + size));
+
+        for(unsigned char byte : bytes)
+            hex += std::string(1, hexDigits[byte >> 4]) + hexDigits[byte & 15];
+
+        for(std::size_t i = 0; i < size; i += 3)
+        {
+            const unsigned value = static_cast<unsigned char>(bytes[i]) << 16 | (i + 1 < size ? static_cast<unsigned char>(bytes[i + 1]) << 8 : 0) | (i + 2 < size ? static_cast<unsigned char>(bytes[i + 2]) : 0);
+            base64 += std::string(1, base64Digits[value >> 18]) + base64Digits[(value >> 12) & 63];
+            base64 += i + 1 < size ? base64Digits[(value >> 6) & 63] : '=';
+            base64 += i + 2 < size ? base64Digits[value & 63] : '=';
+        }
+
+        if(size % 2)
+        {
+            for(char &c : hex)
+                c = c >= 'a' ? static_cast<char>(c - 'a' + 'A') : c;
+        }
+
+        std::vector<unsigned char> hexBuffer(size + 1);
+        std::vector<unsigned char> base64Buffer(size + 1);
+        cppcommandline::Blob hexBlob(hexBuffer.data(), size, cppcommandline::Blob::Encoding::Hex);
+        cppcommandline::Blob base64Blob(base64Buffer.data(), size);
+        cppcommandline::Parser parser;
+        parser.option("key").bindTo(hexBlob);
+        parser.option("certificate").bindTo(base64Blob);
+        std::vector<const char*> args{"./app", "--key", hex.c_str(), "--certificate", base64.c_str()};
+        parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+        QCOMPARE(hexBlob.size(), size);
+        QCOMPARE(base64Blob.size(), size);
+        QCOMPARE(std::string(hexBuffer.begin(), hexBuffer.begin() + size), bytes);
+        QCOMPARE(std::string(base64Buffer.begin(), base64Buffer.begin() + size), bytes);
+    }
+    }
+
+    {
+    SCENARIO("Malformed or oversized blobs do not match")
+    unsigned char buffer[32] = {};
+    cppcommandline::Blob blob(buffer, sizeof(buffer), cppcommandline::Blob::Encoding::Hex);
+    cppcommandline::Parser parser;
+    parser.option("key").bindTo(blob);
+    QCOMPARE(parseError(parser, {"./app", "--key", "00112233445566778899aabbccddeeff0011223344556677889g"}), std::string("No option matches argument '--key'"));
+    QCOMPARE(parseError(parser, {"./app", "--key", "0g"}), std::string("No option matches argument '--key'"));
+    QCOMPARE(parseError(parser, {"./app", "--key", "012"}), std::string("No option matches argument '--key'"));
+    const std::string oversized(66, '0');
+    QCOMPARE(parseError(parser, {"./app", "--key", oversized.c_str()}), std::string("No option matches argument '--key'"));
+    QCOMPARE(blob.size(), std::size_t(0));
+    QVERIFY(cppcommandline::BlobDecoder::decodeBase64("QUJD", 4, buffer));
+    QVERIFY(!cppcommandline::BlobDecoder::decodeBase64("QUJDRE-GSElKS0xNTk9QUVJT", 24, buffer));
+    QVERIFY(!cppcommandline::BlobDecoder::decodeBase64("QU=D", 4, buffer));
+    QVERIFY(!cppcommandline::BlobDecoder::decodeBase64("QUJ", 3, buffer));
+    }
+
+    {
+    SCENARIO("String views point into the arguments")
+    std::string payload(40000, 'x');
+    std::vector<const char*> args{"./app", "--payload", payload.c_str(), "input"};
+    cppcommandline::Parser parser;
+    cppcommandline::StringView view;
+    cppcommandline::StringView input;
+    parser.option("payload").bindTo(view);
+    parser.option().bindTo(input);
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(view.data() == payload.c_str());
+    QCOMPARE(view.size(), payload.size());
+    QCOMPARE(input.str(), std::string("input"));
+    QVERIFY_EXCEPTION_THROWN(parser.parseSettings(static_cast<int>(args.size()), const_cast<char**>(args.data())), std::logic_error);
+    const char data[] = "--payload\0hello\0world\0";
+    std::istringstream stream(std::string(data, sizeof(data) - 1));
+    cppcommandline::ArgumentReader reader(stream);
+    QVERIFY_EXCEPTION_THROWN(parser.parse(reader), std::logic_error);
+    QVERIFY(view.data() == payload.c_str());
+    }
+}
+
+void CppCommandLineTest::finalize()
+{
+    const auto finalizeError = [](cppcommandline::Parser &parser) -> std::string {
+        try
+        {
+            parser.finalize();
+        }
+        catch(const std::logic_error &e)
+        {
+            return e.what();
+        }
+
+        return std::string();
+    };
+
+    {
+    SCENARIO("Duplicate long and short names are reported")
+    cppcommandline::Parser parser;
+    parser.option("value").asShortName("v");
+    parser.option("verbose").asShortName("v");
+    parser.option("value");
+    QCOMPARE(finalizeError(parser), std::string("The name '--value' is declared by more than one option. The name '-v' is declared by more than one option."));
+    QVERIFY(!parser.isFrozen());
+    }
+
+    {
+    SCENARIO("Names of the help option cannot be declared unless help is disabled")
+    cppcommandline::Parser parser;
+    parser.option("host").asShortName("h");
+    parser.option("help");
+    QCOMPARE(finalizeError(parser), std::string("The option 'host' is shadowed by the help option. The option 'help' is shadowed by the help option."));
+    parser.disableHelp();
+    QCOMPARE(finalizeError(parser), std::string());
+    QVERIFY(parser.isFrozen());
+    }
+
+    {
+    SCENARIO("Required positional arguments cannot follow optional ones")
+    cppcommandline::Parser parser;
+    int first = 0;
+    int second = 0;
+    parser.option().bindTo(first);
+    parser.option().required().bindTo(second);
+    QCOMPARE(finalizeError(parser), std::string("The required positional argument 2 follows an optional one."));
+    }
+
+    {
+    SCENARIO("Valid schema is finalized once and parsed")
+    cppcommandline::Parser parser;
+    int threads = 0;
+    std::string input;
+    parser.option().required().bindTo(input);
+    parser.option("threads").asShortName("t").bindTo(threads);
+    parser.finalize();
+    parser.finalize();
+    QVERIFY(parser.isFrozen());
+    std::vector<const char*> args{"./app", "file", "-t", "4"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(threads, 4);
+    QCOMPARE(input, std::string("file"));
+    }
+}
+
+void CppCommandLineTest::help()
+{
+
+    {
+    SCENARIO("Unmatched required option")
+    std::vector<const char*> args{"./app", "-h"};
+    cppcommandline::Parser parser;
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(parser.helpDisplayed());
+    args = {"./app"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QVERIFY(!parser.helpDisplayed());
+    }
+
+    {
+    SCENARIO("Help and errors are written to the output sink")
+    cppcommandline::Parser parser;
+    std::string output;
+    int value = 0;
+    parser.setOutput([&](const std::string &text) { output += text; });
+    parser.option("value").asShortName("v").withDefaultValue(1.5).withDescription("Ratio");
+    parser.option().required().withDescription("File").bindTo(value);
+    std::vector<const char*> args{"./app", "--help"};
+    parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    QCOMPARE(output, std::string("Usage: app [options]\n"
+                                 "Options:\n"
+                                 "    -v, --value          [default=1.5]       Ratio\n"
+                                 "    [positional]         [required]          File\n"
+                                 "\n"));
+    output.clear();
+    QCOMPARE(parseError(parser, {"./app", "--zzz"}), std::string("No option matches argument '--zzz'"));
+    QCOMPARE(output, std::string("Error parsing command line arguments: No option matches argument '--zzz'\n"
+                                 "Use --help or -h to list the command line options.\n"));
+    }
+
+}
+
+std::string CppCommandLineTest::parseError(cppcommandline::Parser &parser, std::vector<const char*> args)
+{
+    try
+    {
+        parser.parse(static_cast<int>(args.size()), const_cast<char**>(args.data()));
+    }
+    catch(std::logic_error &e)
+    {
+        return e.what();
     }
 
+    return std::string();
 }
 
 QTEST_APPLESS_MAIN(CppCommandLineTest)
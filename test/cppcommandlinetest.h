@@ -3,6 +3,11 @@
 #include <QObject>
 #include <memory>
 
+namespace cppcommandline
+{
+class Parser;
+}
+
 class CppCommandLineTest : public QObject
 {
     Q_OBJECT
@@ -22,8 +27,31 @@ private slots:
     void ParserOptionLongName();
     void parse();
     void parseFailed();
+    void parseAllocations();
+    void scan();
+    void freeze();
+    void frozenStorage();
+    void settings();
+    void suggestions();
+    void abbreviations();
+    void reader();
+    void constraints();
+    void numberLists();
+    void lazy();
+    void stringPool();
+    void helpSearch();
+    void passthrough();
+    void dispatcher();
+    void trace();
+    void tuples();
+    void server();
+    void actions();
+    void schema();
+    void blobs();
+    void finalize();
     void help();
 
 private:
     std::unique_ptr<char**, void(*)(char**)> createArguments(std::vector<std::string> arguments);
+    std::string parseError(cppcommandline::Parser &parser, std::vector<const char*> args);
 };
@@ -0,0 +1,26 @@
+#include "secondunit.h"
+#include "cppcommandline.h"
+#include "cppcommandlineblob.h"
+#include "cppcommandlinehelp.h"
+#include "cppcommandlinepool.h"
+#include "cppcommandlinetrace.h"
+
+#ifndef _WIN32
+#include "cppcommandlineserver.h"
+#endif
+
+int parseInSecondUnit(int argc, char **argv)
+{
+    cppcommandline::Parser parser;
+    int threads = 0;
+    std::vector<int> sizes;
+    cppcommandline::StringView name;
+    unsigned char buffer[16];
+    cppcommandline::Blob key(buffer, sizeof(buffer));
+    parser.option("threads").withRange(1, 64).withDefaultValue(1).bindTo(threads);
+    parser.option("sizes").bindTo(sizes);
+    parser.option("name").bindTo(name);
+    parser.option("key").bindTo(key);
+    parser.parse(argc, argv);
+    return threads + static_cast<int>(sizes.size());
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+int parseInSecondUnit(int argc, char **argv);